@@ -0,0 +1,213 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "../songs/catalog.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Headless benchmark rendering every song of songs/ at several sample rates and block sizes, the results are
+ * written as JSON so that two versions of the engine can be compared.
+ * Build it with every .cpp file of src/ and songs/, SFML is not needed.
+ * Usage : benchmark [output.json] [seconds of audio per run] [repeats]
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define DEFAULT_OUTPUT "benchmark.json"
+#define DEFAULT_SECONDS 10.
+#define DEFAULT_REPEATS 3
+#define CHANNEL_COST_SAMPLE_RATE 44100.
+#define CHANNEL_COST_BLOCK 256
+
+/**
+ * @brief every new of the program is counted, a measure reads the counters before and after the code it times
+ */
+static std::atomic<uint_fast64_t> allocations(0);
+static std::atomic<uint_fast64_t> allocated_bytes(0);
+
+static void* allocate(size_t size) {
+    ++allocations;
+    allocated_bytes += size;
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+/**
+ * @brief over-aligned types (rows of patterns, ring buffers) get an aligned block, the address returned by malloc is
+ * kept just before it
+ */
+static void* allocate(size_t size, std::align_val_t alignment) {
+    auto align = size_t(alignment);
+    auto *base = static_cast<char*>(allocate(size + align + sizeof(void*)));
+    auto aligned = (reinterpret_cast<uintptr_t>(base) + sizeof(void*) + align - 1) & ~uintptr_t(align - 1);
+    reinterpret_cast<void**>(aligned)[-1] = base;
+    return reinterpret_cast<void*>(aligned);
+}
+
+static void release(void *p, std::align_val_t) {
+    if (p != nullptr) {
+        std::free(static_cast<void**>(p)[-1]);
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t alignment) noexcept { release(p, alignment); }
+void operator delete[](void *p, std::align_val_t alignment) noexcept { release(p, alignment); }
+void operator delete(void *p, size_t, std::align_val_t alignment) noexcept { release(p, alignment); }
+void operator delete[](void *p, size_t, std::align_val_t alignment) noexcept { release(p, alignment); }
+
+using catalog::Song;
+
+static const double SAMPLE_RATES[] = {22050., 44100., 48000., 96000.};
+static const size_t BLOCK_SIZES[] = {64, 256, 1024, 4096};
+
+#define ALL_CHANNELS (-1)
+#define NO_CHANNEL (-2)
+
+struct Measure {
+    double seconds;
+    uint_fast64_t allocations;
+    uint_fast64_t bytes;
+};
+
+/**
+ * @brief Renders the beginning of a song block by block like an audio callback would
+ * @param song song to render, a new track is created for each call
+ * @param sample_rate sample rate in Hz
+ * @param block number of frames per render call
+ * @param frames total number of frames to render
+ * @param solo index of the only channel enabled, ALL_CHANNELS or NO_CHANNEL
+ * @return wall time and allocations of the rendering only, the track creation is not counted
+ */
+static Measure measure(const Song &song, double sample_rate, size_t block, size_t frames, int solo) {
+    //channels are numbered explicitly, the default constructor keeps counting from the previous songs
+    std::vector<C0deTracker::Channel> chans;
+    chans.reserve(song.channels);
+    for (uint_fast8_t i = 0; i < song.channels; ++i) {
+        chans.emplace_back(i);
+        if (solo != ALL_CHANNELS && solo != i) {
+            chans[i].disable();
+        }
+    }
+    C0deTracker::Track *track = song.init_track();
+    std::vector<float> out(2 * block);
+
+    uint_fast64_t allocations_before = allocations, bytes_before = allocated_bytes;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < frames; done += block) {
+        size_t n = frames - done < block ? frames - done : block;
+        track->render(out.data(), n, double(done) / sample_rate, sample_rate, chans.data(), song.channels);
+    }
+    auto end = std::chrono::steady_clock::now();
+    Measure m = {std::chrono::duration<double>(end - start).count(), allocations - allocations_before,
+                 allocated_bytes - bytes_before};
+
+    delete track;
+    return m;
+}
+
+/**
+ * @return the fastest of several renders, the allocations do not change from one render to another
+ */
+static Measure best(const Song &song, double sample_rate, size_t block, size_t frames, int solo, int repeats) {
+    Measure m = measure(song, sample_rate, block, frames, solo);
+    for (int i = 1; i < repeats; ++i) {
+        Measure other = measure(song, sample_rate, block, frames, solo);
+        if (other.seconds < m.seconds) {
+            m.seconds = other.seconds;
+        }
+    }
+    return m;
+}
+
+static Measure construction(const Song &song) {
+    uint_fast64_t allocations_before = allocations, bytes_before = allocated_bytes;
+    auto start = std::chrono::steady_clock::now();
+    C0deTracker::Track *track = song.init_track();
+    auto end = std::chrono::steady_clock::now();
+    Measure m = {std::chrono::duration<double>(end - start).count(), allocations - allocations_before,
+                 allocated_bytes - bytes_before};
+    delete track;
+    return m;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : DEFAULT_OUTPUT;
+    double seconds = argc > 2 ? std::atof(argv[2]) : DEFAULT_SECONDS;
+    int repeats = argc > 3 ? std::atoi(argv[3]) : DEFAULT_REPEATS;
+    if (seconds <= 0. || repeats < 1) {
+        std::fprintf(stderr, "usage : %s [output.json] [seconds] [repeats]\n", argv[0]);
+        return 1;
+    }
+    //the songs and the engine print on stdout, so the results go to a file
+    FILE *json = std::fopen(path, "w");
+    if (json == nullptr) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+
+    std::fprintf(json, "{\n  \"instruction_set\": \"%s\",\n  \"render_block_size\": %d,\n",
+                 C0deTracker::Oscillator::getInstructionSet(), RENDER_BLOCK_SIZE);
+    std::fprintf(json, "  \"seconds\": %g,\n  \"repeats\": %d,\n  \"songs\": [\n", seconds, repeats);
+    for (size_t s = 0; s < catalog::SIZE_OF_SONGS; ++s) {
+        const Song &song = catalog::SONGS[s];
+        std::fprintf(stderr, "%s\n", song.name);
+        Measure c = construction(song);
+        std::fprintf(json, "    {\n      \"name\": \"%s\",\n      \"channels\": %u,\n", song.name, unsigned(song.channels));
+        std::fprintf(json, "      \"construction\": {\"seconds\": %.9f, \"allocations\": %llu, \"bytes\": %llu},\n",
+                     c.seconds, (unsigned long long) c.allocations, (unsigned long long) c.bytes);
+
+        std::fprintf(json, "      \"runs\": [\n");
+        bool first = true;
+        for (double sample_rate : SAMPLE_RATES) {
+            auto frames = size_t(seconds * sample_rate);
+            for (size_t block : BLOCK_SIZES) {
+                Measure m = best(song, sample_rate, block, frames, ALL_CHANNELS, repeats);
+                std::fprintf(json, "%s        {\"sample_rate\": %g, \"block\": %zu, \"frames\": %zu, \"seconds\": %.9f, "
+                                   "\"samples_per_second\": %.1f, \"real_time_factor\": %.3f, \"allocations\": %llu, "
+                                   "\"bytes\": %llu}", first ? "" : ",\n", sample_rate, block, frames, m.seconds,
+                             double(frames) / m.seconds, seconds / m.seconds, (unsigned long long) m.allocations,
+                             (unsigned long long) m.bytes);
+                first = false;
+            }
+        }
+        std::fprintf(json, "\n      ],\n");
+
+        //cost of a channel = rendering it alone minus rendering the sequencer with every channel disabled
+        auto frames = size_t(seconds * CHANNEL_COST_SAMPLE_RATE);
+        Measure all = best(song, CHANNEL_COST_SAMPLE_RATE, CHANNEL_COST_BLOCK, frames, ALL_CHANNELS, repeats);
+        Measure none = best(song, CHANNEL_COST_SAMPLE_RATE, CHANNEL_COST_BLOCK, frames, NO_CHANNEL, repeats);
+        std::fprintf(json, "      \"channel_cost\": {\"sample_rate\": %g, \"block\": %d, \"all_seconds\": %.9f, "
+                           "\"sequencer_seconds\": %.9f, \"channels\": [\n", CHANNEL_COST_SAMPLE_RATE,
+                     CHANNEL_COST_BLOCK, all.seconds, none.seconds);
+        for (uint_fast8_t i = 0; i < song.channels; ++i) {
+            Measure solo = best(song, CHANNEL_COST_SAMPLE_RATE, CHANNEL_COST_BLOCK, frames, i, repeats);
+            double cost = solo.seconds > none.seconds ? solo.seconds - none.seconds : 0.;
+            std::fprintf(json, "%s        {\"channel\": %u, \"seconds\": %.9f, \"share\": %.4f}", i ? ",\n" : "",
+                         unsigned(i), cost, cost / all.seconds);
+        }
+        std::fprintf(json, "\n      ]}\n    }%s\n", s + 1 < catalog::SIZE_OF_SONGS ? "," : "");
+    }
+    std::fprintf(json, "  ]\n}\n");
+    std::fclose(json);
+    return 0;
+}
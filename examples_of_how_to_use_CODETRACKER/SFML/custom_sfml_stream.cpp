@@ -6,38 +6,38 @@
 bool C0deTrackerStream::init(C0deTracker::Track *t, C0deTracker::Channel *c, uint_fast8_t  size_of_c) {
     printf("SAMPLE RATE = %f Hz\nBUFFER LENGTH = %f second\n", SAMPLE_RATE, BUFFER_LENGTH_S);
     this->track = t; this->chans = c; this->size_of_chans = size_of_c;
+    this->track->setCheckpointInterval(CHECKPOINT_ROWS);//seeking replays at most CHECKPOINT_ROWS rows
+    this->renderer = new C0deTracker::RenderThread(t, c, size_of_c, SAMPLE_RATE, size_t(SAMPLE_RATE * LOOKAHEAD_S));
+    this->renderer->start(this->time);
     // Initialize the stream -- important!
     sf::SoundStream::initialize(PANNING, SAMPLE_RATE);
     return true;
 }
 
+C0deTrackerStream::~C0deTrackerStream() {
+    sf::SoundStream::stop();
+    delete this->renderer;
+}
+
 bool C0deTrackerStream::onGetData(sf::SoundStream::Chunk &data) {
-    sf::Lock lock(this->mutex);
-    float* sound;
     // Fill the chunk with audio data from the stream source
     // (note: must not be empty if you want to continue playing)
-    std::chrono::time_point t1 = std::chrono::system_clock::now();
+    // The samples are already rendered by the render thread, they are only copied here
+    this->renderer->pull(this->sound, SAMPLE_RATE * BUFFER_LENGTH_S);
     for(int i = 0; i < SAMPLE_RATE * BUFFER_LENGTH_S * PANNING; ++++i){
-        sound = track->play(this->time + (double(i) / 2) / SAMPLE_RATE, this->chans, this->size_of_chans);
-        this->smpls[i] = sound[0] * BITS_16*0.5;
-        this->smpls[i+1] = sound[1] * BITS_16*0.5;
+        this->smpls[i] = this->sound[i] * BITS_16*0.5;
+        this->smpls[i+1] = this->sound[i+1] * BITS_16*0.5;
     }
     data.samples = this->smpls;
     data.sampleCount = SAMPLE_RATE * BUFFER_LENGTH_S * PANNING;
     this->time += BUFFER_LENGTH_S;
-    std::chrono::time_point t2 = std::chrono::system_clock::now();
-
-    double deltaT = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-    //std::cout << "CALC buffer time = " << deltaT << " ms" << std::endl;
 
     // Return true to continue playing
     return true;
 }
 
 void C0deTrackerStream::onSeek(sf::Time timeOffset) {
-    sf::Lock lock(this->mutex);
     this->time = timeOffset.asSeconds();
     // Change the current position in the stream source
+    this->renderer->seek(this->time);
 }
-
-
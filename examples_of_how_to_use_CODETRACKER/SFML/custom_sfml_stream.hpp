@@ -2,8 +2,6 @@
 // Created by Abdulmajid, Olivier NASSER on 20/09/2020.
 //
 #include <SFML/Audio.hpp>
-#include <SFML/System/Lock.hpp>
-#include <SFML/System/Mutex.hpp>
 #include "../../include/c0de_tracker.hpp"
 #include <iostream>
 #include <chrono>
@@ -11,20 +9,23 @@
 #ifndef CODETRACKER_CUSTOM_SFML_STREAM_HPP
 #define CODETRACKER_CUSTOM_SFML_STREAM_HPP
 #define SAMPLE_RATE 48000.
-#define BUFFER_LENGTH_S 0.5
+#define BUFFER_LENGTH_S 0.01 //latency of the device, the synthesis runs on its own thread
+#define LOOKAHEAD_S 0.1 //rendered in advance to absorb the synthesis spikes
 #define PANNING 2
 #define BITS_16 0xFFFF
 class C0deTrackerStream : public sf::SoundStream {
 public:
     double time = 0;
     bool init(C0deTracker::Track *t, C0deTracker::Channel *c, uint_fast8_t  size_of_c);
+    ~C0deTrackerStream() override;
 
 private:
     C0deTracker::Track *track = nullptr;
     C0deTracker::Channel *chans = nullptr;
     uint_fast8_t  size_of_chans = 0;
-    sf::Mutex mutex;
+    C0deTracker::RenderThread *renderer = nullptr;
     std::vector <sf::Int16> samples;
+    float sound[static_cast<int>(SAMPLE_RATE * BUFFER_LENGTH_S * PANNING)]{0};
     sf::Int16 smpls[static_cast<int>(SAMPLE_RATE * BUFFER_LENGTH_S * PANNING)]{0};
 
     bool onGetData(Chunk &data) override;
@@ -47,10 +47,13 @@ int main() {
     float number_of_samples = SAMPLE_RATE * duration_in_sec * PANNING;
     samples.reserve(number_of_samples);
 
-    for (uint_fast64_t i = 0; i < number_of_samples; ++++i) {
-        float* s = track->play(0.5 * double(i) / SAMPLE_RATE, chans, size_of_chans);
-        samples.push_back((s[0]) * BITS_16*0.5);//left speaker
-        samples.push_back((s[1]) * BITS_16*0.5);//right speaker
+    //the whole song on every core, with its own channels (the channels disabled above are ignored)
+    size_t frames = size_t(number_of_samples) / PANNING;
+    std::vector<float> song(frames * PANNING);
+    track->exportSong(song.data(), frames, SAMPLE_RATE, std::thread::hardware_concurrency());
+    for (size_t j = 0; j < frames * PANNING; ++++j) {
+        samples.push_back((song[j]) * BITS_16*0.5);//left speaker
+        samples.push_back((song[j + 1]) * BITS_16*0.5);//right speaker
     }
 
     buffer.loadFromSamples(&samples[0], samples.size(), PANNING, SAMPLE_RATE);
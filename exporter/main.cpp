@@ -0,0 +1,96 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../songs/catalog.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Exports every song of songs/ to a .ctk file, then checks that the track loaded from the file renders exactly
+ * the same samples as the track built by the song code.
+ * Build it with every .cpp file of src/ and songs/, SFML is not needed.
+ * Usage : exporter [output directory] [sample rate]
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define DEFAULT_SAMPLE_RATE 48000.
+#define VERIFY_BLOCK 4096
+
+using catalog::Song;
+
+/**
+ * @brief Renders the whole song with the original track and with the loaded one, block after block
+ * @return index of the first frame which differs, or frames if both renders are identical
+ */
+static size_t compare(const Song &song, C0deTracker::Track *original, C0deTracker::Track *loaded, size_t frames,
+                      double sample_rate) {
+    //channels are numbered explicitly, the default constructor keeps counting from the previous songs
+    std::vector<C0deTracker::Channel> a, b;
+    a.reserve(song.channels);
+    b.reserve(song.channels);
+    for (uint_fast8_t i = 0; i < song.channels; ++i) {
+        a.emplace_back(i);
+        b.emplace_back(i);
+    }
+    std::vector<float> x(2 * VERIFY_BLOCK), y(2 * VERIFY_BLOCK);
+    for (size_t done = 0; done < frames; done += VERIFY_BLOCK) {
+        size_t n = frames - done < VERIFY_BLOCK ? frames - done : VERIFY_BLOCK;
+        double t = double(done) / sample_rate;
+        original->render(x.data(), n, t, sample_rate, a.data(), song.channels);
+        loaded->render(y.data(), n, t, sample_rate, b.data(), song.channels);
+        if (std::memcmp(x.data(), y.data(), 2 * n * sizeof(float)) != 0) {
+            size_t i = 0;
+            while (std::memcmp(&x[2 * i], &y[2 * i], 2 * sizeof(float)) == 0) {
+                ++i;
+            }
+            return done + i;
+        }
+    }
+    return frames;
+}
+
+int main(int argc, char **argv) {
+    std::string directory = argc > 1 ? argv[1] : ".";
+    double sample_rate = argc > 2 ? std::atof(argv[2]) : DEFAULT_SAMPLE_RATE;
+    if (sample_rate <= 0.) {
+        std::fprintf(stderr, "usage : %s [output directory] [sample rate]\n", argv[0]);
+        return 1;
+    }
+
+    int failures = 0;
+    for (const Song &song : catalog::SONGS) {
+        std::string path = directory + "/" + song.name + ".ctk";
+        C0deTracker::Track *original = song.init_track();
+        if (!C0deTracker::SongFile::save(*original, path.c_str())) {
+            ++failures;
+            delete original;
+            continue;
+        }
+        C0deTracker::Track *loaded = C0deTracker::SongFile::load(path.c_str());
+        if (loaded == nullptr) {
+            ++failures;
+            delete original;
+            continue;
+        }
+
+        auto frames = size_t(double(original->getDuration()) * sample_rate);
+        size_t same = compare(song, original, loaded, frames, sample_rate);
+        if (same == frames) {
+            std::fprintf(stderr, "%s : %zu frames identical\n", path.c_str(), frames);
+        } else {
+            std::fprintf(stderr, "%s : renders differ from frame %zu (%.3f s)\n", path.c_str(), same,
+                         double(same) / sample_rate);
+            ++failures;
+        }
+        delete loaded;
+        delete original;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -39,24 +39,58 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdint>
+#include <cstddef>
 #include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
 namespace C0deTracker {
 #define TWOPI 6.283185307
 #define MASTER_VOLUME 1.f
+#define RENDER_BLOCK_SIZE 256
+#define CHECKPOINT_ROWS 16
+#define ARENA_CHUNK_SIZE 65536 //bytes reserved by an Arena when it runs out of memory
+#define CTK_VERSION 3 //version of the .ctk song files written by SongFile::save
+#define EMPTY_PATTERN 0 //index of the empty pattern in a PatternPool
+#define EFFECT_COLUMNS 4 //effects stored in each row, a pattern keeps at most this number of effects per instruction
+#define SEMITONE_LOG2 0.08333000000054397 //log2 of the semitone ratio 1.059460646483
+#define ENVELOPE_ATTACK_RATIO 0.3 //exponential attack aims at 1 + this ratio, so it reaches 1 in the attack time
+#define ENVELOPE_DECAY_RATIO 0.0001 //exponential decay and release aim this ratio below their end, same idea
+#define LFSR_SEED 1 //value of the noise shift register when a note starts
+#define LFSR_LONG_TAP 1 //bit xored with bit 0 for the long noise, 32767 steps before it repeats
+#define LFSR_SHORT_TAP 6 //bit xored with bit 0 for the short (metallic) noise, 93 steps before it repeats
+#define LFSR_LONG_PERIOD 32767 //every state of the long noise comes back after this number of steps
+#define LFSR_SHORT_PERIOD 93 //every state of the short noise comes back after this number of steps (or 31)
 
 
     struct Key;
     struct ADSR;
+    struct VoiceState;
     class Oscillator;
     class PSG;
+    class BandLimitedPSG;
+    class Wavetable;
     class Instrument;
     struct Instruction;
     struct Pattern;
+    struct EffectCommand;
+    struct RowEvent;
+    class Arena;
+    class PatternPool;
+    class SongFile;
     class Track;
     class Channel;
     class Editor;
+    class WorkerPool;
+    class RingBuffer;
+    class RenderThread;
 
 
 
@@ -69,13 +103,13 @@ namespace C0deTracker {
         /**
          * @brief Default constructor of Key. Create an empty key of value 255 (CONTINUE) for the note and the octave.
          */
-        Key();
+        constexpr Key();
         /**
          * @brief Constructor used to provide the corresponding note and octave of the key instantly.
          * @param n note of the key. See enumeration in Notes namespace.
          * @param o octave of the key, from 0 to 8 (above 8 should not be hearable).
          */
-        Key(float n, float o); float note, octave;
+        constexpr Key(float n, float o); float note, octave;
     };
 
     namespace Notes {
@@ -103,10 +137,28 @@ namespace C0deTracker {
         /**
          * @param p pitch2freq
          * @return frequency of the pitch2freq in float
-         * @note Pitch 0 corresponds to 440 Hz.
+         * @note Pitch 0 corresponds to 440 Hz. Computed with fastExp2, with a relative error to
+         * 440 * pow(1.059460646483, p) below 6e-7 for pitches from -60 to 60 (the keys of octaves 0 to 8) and below 8e-7
+         * from -127 to 127 : the float product of the pitch and SEMITONE_LOG2 is rounded before fastExp2.
          */
         float pitch2freq(float p);
 
+        /**
+         * @brief converts a block of pitches in frequencies
+         * @param f buffer receiving the n frequencies
+         * @param p pitches
+         * @param n number of pitches
+         * @note Gives the same frequencies as pitch2freq(float p), 4 pitches at a time with SSE2.
+         */
+        void pitch2freq(float* f, const float* p, size_t n);
+
+        /**
+         * @brief Fast approximation of 2^x, used instead of pow to convert pitches in frequencies
+         * @param x exponent between -126 and 127
+         * @return 2^x, with a relative error below 2.5e-7 (less than 0.001 cent once used as a frequency ratio)
+         */
+        float fastExp2(float x);
+
         /**
          * @brief converts a key in float
          * @param k Key (note)
@@ -140,6 +192,20 @@ namespace C0deTracker {
         float key2freq(Key key);
     }
 
+    constexpr Key::Key() : note(Notes::CONTINUE), octave(Notes::CONTINUE) {}
+    constexpr Key::Key(float n, float o) : note(n), octave(o) {}
+
+    /**
+     * @brief Slides move a value at each sample by speed * (t - start time of the slide). This function gives the sum
+     * of (t_i - since) over several samples at once, so slides can be evaluated at control rate with the same result.
+     * @param t time of the last sample
+     * @param since start time of the slide
+     * @param samples number of samples covered, ending at t
+     * @param dt time between two samples
+     * @return sum of the elapsed times of each sample
+     */
+    double slideTime(double t, double since, uint_fast32_t samples, double dt);
+
     /**
      * @brief ADSR structure contains attack, decay, sustain and release components (all in float) used to manipulates waveform's
      * envelope (mainly for amplitude).
@@ -147,23 +213,87 @@ namespace C0deTracker {
      * @see C0deTracker::Oscillator
      */
     struct ADSR{
-        ADSR(float A, float D, float S, float R);
+        /**
+         * @brief shapes of the attack, decay and release segments. A linear segment moves at its rate, an exponential
+         * one takes the same time with the curve of an analog envelope (fast then slow).
+         */
+        enum Curves{LINEAR, EXPONENTIAL, CURVES};
+        /**
+         * @brief the segment a voice is in. IDLE means the envelope is 0 until the next note : the release ended, or
+         * the decay ended on a sustain of 0.
+         */
+        enum Segments{ATTACK, DECAY, SUSTAIN, RELEASE, IDLE};
+
+        /**
+         * @param A attack, amplitude per second
+         * @param D decay, amplitude per second
+         * @param S sustain amplitude
+         * @param R release, amplitude per second
+         * @param curve one of Curves
+         */
+        ADSR(float A, float D, float S, float R, uint_fast8_t curve = LINEAR);
         float attack, decay, sustain, release;
+        uint_fast8_t curve = LINEAR;
+
+        /**
+         * @brief computes the envelope of n samples, advancing the segment of the voice sample after sample by a
+         * per-sample increment (linear) or multiplier (exponential). A note restarts when its time goes back.
+         * @param v voice playing the note
+         * @param out receives the amplitude of the envelope of each sample
+         * @param n number of samples
+         * @param t time since the note started, for each sample
+         * @param rt release time of each sample, negative while the note is not released
+         * @return number of samples before the envelope is idle until the end of the block : out[k] is 0 for k from
+         * the returned index to n
+         */
+        size_t render(VoiceState &v, float* out, size_t n, const double* t, const double* rt) const;
     };
 
     /**
      * @brief This enumeration stores the primitive waveforms values. You should provide to your Oscillator one of these
      * values in order to select the corresponding waveform function
+     * @details NOISE_LONG and NOISE_SHORT come from a 15 bits linear-feedback shift register like the noise channel of
+     * the NES, clocked once per period of the frequency (a higher note gives a brighter noise). The long mode sounds
+     * like white noise, the short one repeats after 93 clocks and gives the periodic, metallic noise of the chips.
      * @see C0deTracker::Oscillator
      */
-    enum Waveforms{SINUS, SQUARE, TRIANGLE, SAW, WHITENOISE, WHITENOISE2, WAVETYPES};
+    enum Waveforms{SINUS, SQUARE, TRIANGLE, SAW, WHITENOISE, WHITENOISE2, NOISE_LONG, NOISE_SHORT, WAVETYPES};
+
+    /**
+     * @brief Playback state of one voice, everything which changes while an instrument plays a note. Instruments and
+     * oscillators are read-only definitions, each channel keeps the VoiceState of the note it plays.
+     */
+    struct VoiceState{
+        double phase_acc = 0.0; /**<Normalized phase of the voice in [0, 1), advanced by f * (time between two samples)*/
+        double phase_time = 0.0; /**<Time of the last sample, when time goes back the note restarted*/
+        double envelope = 0.0; /**<Amplitude of the envelope at the last sample*/
+        double envelope_time = 0.0; /**<Time of the note at the last sample of the envelope*/
+        double release_time = 0.0; /**<Release time at the last sample of the envelope, while it is released*/
+        uint8_t segment = ADSR::ATTACK; /**<ADSR::Segments the envelope is in*/
+        bool release = false; /**<The note is released*/
+        uint16_t lfsr = LFSR_SEED; /**<Shift register of the NOISE_LONG and NOISE_SHORT waveforms*/
+
+        /**
+         * @return true if the envelope stays at 0 until the next note
+         */
+        bool isIdle() const { return this->segment == ADSR::IDLE; }
+
+        /**
+         * @param t time since the note started, for each sample
+         * @param n number of samples
+         * @return true if the envelope is idle and no note starts during these samples, so they are all silent
+         */
+        bool staysIdle(const double* t, size_t n) const;
+    };
 
     /**
      * @brief Abstract class used to generate simple waveform such as SINUS, SQUARE, TRIANGLE, SAW and WHITENOISE over
      * time. Oscillator handles basic stuff : amplitude (a), frequency (f), phase (p), duty cycle (dc), and even frequency
      * modulation feed (FMfeed) for FM synth support.
-     * @note This class should not be instantiated. PSG class is one of its specialization.
-     * @see C0deTracker::PSG, C0deTracker::Waveforms
+     * @note This class should not be instantiated. PSG class is one of its specialization. An oscillator is not modified
+     * by playing, the state of the note is in the VoiceState given to each call, so it can be shared between channels,
+     * tracks and threads.
+     * @see C0deTracker::PSG, C0deTracker::Waveforms, C0deTracker::VoiceState
      */
     class Oscillator{
     public :
@@ -186,15 +316,29 @@ namespace C0deTracker {
          */
         explicit Oscillator(uint_fast8_t wavetype, float dc, float p);
         /**
-         * @brief copy oscillator. Used for cloning instruments in channel
+         * @brief advances the oscillator over a block of samples like oscillate would, without computing them
+         * @param v state of the voice
+         * @param n number of samples
+         * @param f Frequency of each sample
+         * @param t Time of each sample
+         * @param rt Release time of each sample, negative while the note is not released
+         * @param dc Duty Cycle
+         * @param p Phase
+         */
+        virtual void skip(VoiceState &v, size_t n, const float* f, const double* t, const double* rt, float dc,
+                          float p) const;
+
+        /**
+         * @brief copy oscillator
          * @return Oscillator allocated dynamically
          */
-        virtual Oscillator* clone() = 0;
+        virtual Oscillator* clone() const = 0;
         virtual ~Oscillator();
 
         /**
          * @brief set the wavetype of the oscillator to generate the corresponding waveform
-         * @param wavetype 0, 1, 2, 3, 4, 5 => SINUS, SQUARE, TRIANGLE, SAW, WHITENOISE, WHITENOISE2
+         * @param wavetype 0, 1, 2, 3, 4, 5, 6, 7 => SINUS, SQUARE, TRIANGLE, SAW, WHITENOISE, WHITENOISE2, NOISE_LONG,
+         * NOISE_SHORT
          * @see Waveforms
          */
         void setWavetype(uint_fast8_t wavetype);
@@ -202,7 +346,7 @@ namespace C0deTracker {
         /**
          * @brief return the value of the corresponding wavetype
          */
-        uint_fast8_t getWavetype();
+        uint_fast8_t getWavetype() const;
 
         /**
          * @brief set the duty cycle of the waveform
@@ -213,7 +357,7 @@ namespace C0deTracker {
          *
          * @return get the duty cycle of the waveform
          */
-        float getDutycycle();
+        float getDutycycle() const;
 
         /**
          * @brief Set the phase of the waveform. The value set is multiplied by 1/frequency (percentage of waveform period)
@@ -224,19 +368,22 @@ namespace C0deTracker {
          *
          * @return the phase in float
          */
-        float getPhase();
+        float getPhase() const;
         /**
-         * @brief Generates corresponding waveform selected.
+         * @brief Generates corresponding waveform selected. The voice keeps its own phase which moves forward by
+         * f * (t - previous t), so the frequency may change from one sample to another without any glitch.
+         * @param v state of the voice
          * @param a Amplitude
          * @param f Frequency
-         * @param t Time
+         * @param t Time since the note started, going back in time restarts the waveform at phase 0
          * @param dc Duty cycle
          * @param p Phase
          * @return Signal amplitude at time t with the given duty cycle dc and phase p.
          */
-        virtual float oscillate(float a, float f, double t, float dc, float p);
+        virtual float oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const;
         /**
          * @brief Same as previous oscillate, but with release time to handle release envelope. This function is fully abstract, it is implemented in PSG.
+         * @param v state of the voice
          * @param a Amplitude
          * @param f Frequency
          * @param rt Release time
@@ -245,33 +392,86 @@ namespace C0deTracker {
          * @param p Phase
          * @return Signal amplitude at time t with the given duty cycle dc and phase p.
          */
-        virtual float oscillate(float a, float f, double t, double rt, float dc, float p) = 0;
+        virtual float oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const = 0;
+        /**
+         * @brief Generates a block of the selected waveform. The waveform kernels are vectorized (AVX2 or SSE2, chosen
+         * at startup for the running CPU) and give the same samples as the scalar oscillate.
+         * @param v state of the voice
+         * @param out buffer receiving the n samples
+         * @param n number of samples
+         * @param a Amplitude of each sample
+         * @param f Frequency of each sample
+         * @param t Time since the note started, for each sample
+         * @param rt Release time of each sample, negative while the note is not released
+         * @param dc Duty cycle
+         * @param p Phase
+         */
+        virtual void oscillate(VoiceState &v, float* out, size_t n, const float* a, const float* f, const double* t,
+                               const double* rt, float dc, float p) const;
+        /**
+         * @return name of the instruction set used by the block waveform kernels ("AVX2", "SSE2" or "scalar")
+         */
+        static const char* getInstructionSet();
+        /**
+         * @brief Switches block waveform kernels between the best SIMD version for the CPU and the scalar fallback.
+         * It can be called while other threads render : each block is rendered with the kernels read at its start.
+         * @param enable false to force the scalar kernels
+         */
+        static void enableSimd(bool enable);
         /**
          * @brief Get pointer to structure holding ADSR values for envelope
          * @return pointer to ADSR struct
          * @see C0deTracker::ADSR
          */
-        virtual ADSR* getAmpEnvelope() = 0;
+        virtual const ADSR* getAmpEnvelope() const = 0;
+    protected:
+        /**
+         * @brief moves the phase of the voice to time t
+         * @return normalized phase of the sample in [0, 1), phase p included (output bit of the register for the
+         * shift register noises)
+         */
+        float advancePhase(VoiceState &v, float f, double t, float dc, float p) const;
         /**
-         * @brief Set release state of the oscillator.
-         * @param r boolean to set the release state
+         * @brief multiplies a block of samples by the amplitude envelope
+         * @param v state of the voice
+         * @param out the n samples, multiplied in place
+         * @param n number of samples
+         * @param t Time since the note started, for each sample
+         * @param rt Release time of each sample, negative while the note is not released
          */
-        virtual void setRelease(bool r) = 0;
+        void applyAmpEnvelope(VoiceState &v, float* out, size_t n, const double* t, const double* rt) const;
         /**
-         * @brief Check if the oscillator is in release state or not
-         * @return release member
+         * @brief advances the amplitude envelope over a block of samples without computing them
          */
-        virtual bool isReleased() = 0;
+        void skipAmpEnvelope(VoiceState &v, size_t n, const double* t, const double* rt) const;
+        /**
+         * @brief Reads a block of samples in a single-cycle table, vectorized like the waveform kernels (AVX2 gathers
+         * or SSE2) and giving the same samples as the scalar version.
+         * @param out buffer receiving the n samples
+         * @param n number of samples
+         * @param a Amplitude of each sample
+         * @param ph normalized phase of each sample in [0, 1]
+         * @param table length samples followed by a copy of the first two, so phase 1 can be read
+         * @param length number of samples of one cycle
+         * @param interpolate true for a linear interpolation between two samples, false to hold each sample
+         */
+        static void readTable(float* out, size_t n, const float* a, const float* ph, const float* table,
+                              size_t length, bool interpolate);
     private:
         uint_fast8_t wavetype = SINUS; float dutycycle = 0.5f; float phase = 0.0f;
-        static float sinus(float a, float f, double t, float dc, float FMfeed);
-        static float square(float a, float f, double t, float dc, float FMfeed);
-        static float triangle(float a, float f, double t, float dc, float FMfeed);
-        static float saw(float a, float f, double t, float dc, float FMfeed);
-        static float whitenoise(float a, float f, double t, float dc, float FMfeed);
-        static float whitenoise2(float a, float f, double t, float dc, float FMfeed);
+        void accumulatePhase(VoiceState &v, float f, double t, float dc) const;
+        void clockNoise(VoiceState &v, double clocks) const;
+        /*Waveform kernels, ph is the normalized phase in [0, 1)*/
+        static float sinus(float a, float ph, float dc, float FMfeed);
+        static float square(float a, float ph, float dc, float FMfeed);
+        static float triangle(float a, float ph, float dc, float FMfeed);
+        static float saw(float a, float ph, float dc, float FMfeed);
+        static float whitenoise(float a, float ph, float dc, float FMfeed);
+        static float whitenoise2(float a, float ph, float dc, float FMfeed);
+        /*The shift register noises get the output bit of the register (0 or 1) instead of the phase*/
+        static float lfsrNoise(float a, float bit, float dc, float FMfeed);
 
-        virtual float handleAmpEnvelope(double t, double rt) = 0;
+        virtual float handleAmpEnvelope(VoiceState &v, double t, double rt) const = 0;
 
 
     };
@@ -288,26 +488,124 @@ namespace C0deTracker {
         PSG(uint_fast8_t wavetype, ADSR amp_enveloppe);
         PSG(uint_fast8_t wavetype, float dc, ADSR amp_enveloppe);
         PSG(uint_fast8_t wavetype, float dc, float p, ADSR amp_enveloppe);
-        PSG * clone() override;
+        void skip(VoiceState &v, size_t n, const float* f, const double* t, const double* rt, float dc,
+                  float p) const override;
+        PSG * clone() const override;
         ~PSG() override;
-        float oscillate(float a, float f, double t, float dc, float p) override;
-        float oscillate(float a, float f, double t, double rt, float dc, float p) override;
-        ADSR* getAmpEnvelope() override;
-        void setRelease(bool r) override;
-        bool isReleased() override;
+        float oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const override;
+        float oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const override;
+        void oscillate(VoiceState &v, float* out, size_t n, const float* a, const float* f, const double* t,
+                       const double* rt, float dc, float p) const override;
+        const ADSR* getAmpEnvelope() const override;
     private:
         ADSR amp_envelope = ADSR(100.f, 0.0f, 1.0f, 1.0f);
-        float handleAmpEnvelope(double t, double rt) override;
-    protected:
-        bool release = false;
-        float current_envelope_amplitude = 0.f; /**<Used to calculate envelope notably for release state*/
+        float handleAmpEnvelope(VoiceState &v, double t, double rt) const override;
+    };
+
+    /**
+     * @brief BandLimitedPSG is a PSG reading SQUARE, TRIANGLE and SAW from precomputed band-limited wavetables
+     * instead of computing the analytic formulas, so high notes do not alias.
+     * @details Each waveform has one chain of tables per duty cycle step (the duty cycle is rounded to the nearest
+     * 1/32), every table of a chain keeping half the harmonics of the previous one. The table of each sample is
+     * chosen by octave from the phase step of the voice, so no harmonic goes above the Nyquist frequency, and is read
+     * with linear interpolation. A chain is built the first time it is played and then shared by every oscillator.
+     * The other waveforms are played like a PSG.
+     * @see PSG
+     */
+    class BandLimitedPSG : public PSG{
+    public:
+        explicit BandLimitedPSG(uint_fast8_t wavetype);
+        BandLimitedPSG(uint_fast8_t wavetype, ADSR amp_enveloppe);
+        BandLimitedPSG(uint_fast8_t wavetype, float dc, ADSR amp_enveloppe);
+        BandLimitedPSG(uint_fast8_t wavetype, float dc, float p, ADSR amp_enveloppe);
+        BandLimitedPSG * clone() const override;
+        ~BandLimitedPSG() override;
+        using PSG::oscillate;
+        float oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const override;
+        void oscillate(VoiceState &v, float* out, size_t n, const float* a, const float* f, const double* t,
+                       const double* rt, float dc, float p) const override;
+        /**
+         * @return true if the waveform is read from the band-limited tables (SQUARE, TRIANGLE and SAW)
+         */
+        bool isBandLimited() const;
+    };
+
+    /**
+     * @brief Wavetable class inherit from Oscillator, like PSG. It plays a user-defined single-cycle table, such as the
+     * 32 steps of 4 bits of the Game Boy and Namco wave channels or a larger table of floats, with the same amplitude
+     * envelope as a PSG.
+     * @details The table is read at the phase of the voice, with a linear interpolation between two samples or holding
+     * each sample like the chips do. The PSG waveforms go from -0.5 to 0.5, so do the tables of steps. The wavetype
+     * of the Oscillator is not used.
+     * @see Oscillator, PSG
+     */
+    class Wavetable : public Oscillator{
+    public:
+        enum Interpolations{NEAREST, LINEAR};
+        /**
+         * @param samples one cycle of the waveform
+         * @param length number of samples
+         * @param amp_enveloppe amplitude envelope
+         * @param interpolation Interpolations used to read the table
+         */
+        Wavetable(const float* samples, size_t length, ADSR amp_enveloppe, uint_fast8_t interpolation = LINEAR);
+        /**
+         * @param steps one cycle of the waveform, each step from 0 to 2^bits - 1
+         * @param length number of steps
+         * @param bits resolution of the steps (4 for the Game Boy), clamped from 1 to 16
+         * @param amp_enveloppe amplitude envelope
+         * @param interpolation Interpolations used to read the table
+         */
+        Wavetable(const uint8_t* steps, size_t length, uint_fast8_t bits, ADSR amp_enveloppe,
+                  uint_fast8_t interpolation = NEAREST);
+        Wavetable * clone() const override;
+        ~Wavetable() override;
+        void skip(VoiceState &v, size_t n, const float* f, const double* t, const double* rt, float dc,
+                  float p) const override;
+        float oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const override;
+        float oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const override;
+        void oscillate(VoiceState &v, float* out, size_t n, const float* a, const float* f, const double* t,
+                       const double* rt, float dc, float p) const override;
+        const ADSR* getAmpEnvelope() const override;
+
+        /**
+         * @brief replaces the table, the voices playing it continue at the same phase
+         * @param samples one cycle of the waveform
+         * @param length number of samples, an empty table is silent
+         */
+        void setTable(const float* samples, size_t length);
+        /**
+         * @brief replaces the table by steps of a few bits, mapped from -0.5 to 0.5
+         * @param steps one cycle of the waveform, each step from 0 to 2^bits - 1
+         * @param length number of steps, an empty table is silent
+         * @param bits resolution of the steps, clamped from 1 to 16
+         */
+        void setTable(const uint8_t* steps, size_t length, uint_fast8_t bits);
+        /**
+         * @return the samples of one cycle
+         */
+        const float* getTable() const;
+        /**
+         * @return number of samples of one cycle
+         */
+        size_t getLength() const;
+
+        void setInterpolation(uint_fast8_t interpolation);
+        uint_fast8_t getInterpolation() const;
+    private:
+        std::vector<float> table;//one cycle followed by its first two samples
+        uint_fast8_t interpolation = LINEAR;
+        ADSR amp_envelope = ADSR(100.f, 0.0f, 1.0f, 1.0f);
+        float handleAmpEnvelope(VoiceState &v, double t, double rt) const override;
     };
 
     /**
      * @brief Instrument class is a wrapper for one Oscillator (PSG, or FM). You will basically create your instruments
      * in a bank (simple array) that you give to your track.
+     * @details An instrument is a read-only definition : playing it only changes the VoiceState given to each call,
+     * so the channels play the instruments of the bank without copying them.
      *
-     * @see Track
+     * @see Track, VoiceState
      */
     class Instrument{
     public:
@@ -329,43 +627,57 @@ namespace C0deTracker {
         ~Instrument();
 
         /**
-         * @brief copy Instrument. Used in channel
+         * @brief copy Instrument
          * @return Instrument allocated dynamically
          */
-        Instrument* clone();
+        Instrument* clone() const;
 
         /**
-         * @brief Gets instrument core, which is the Oscillator
+         * @brief Gets instrument core, which is the Oscillator, to change it before the bank is given to a track
          * @return a pointer to Oscillator
          */
-        Oscillator* get_oscillator() const;
+        Oscillator* get_oscillator();
+        /**
+         * @brief Gets instrument core, which is the Oscillator
+         * @return a pointer to the read-only Oscillator
+         */
+        const Oscillator* get_oscillator() const;
+
+        /**
+         * @return volume applied to everything the instrument plays
+         */
+        float getGlobalVolume() const;
         /**
          * @brief Plays sounds at t time with a given key and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param k Structure Key (note, octave)
          * @param t Time
          * @return The signal
          */
-        float play_key(float a, Key k, double t);
+        float play_key(VoiceState &v, float a, Key k, double t) const;
         /**
          * @brief Plays sounds at t time with a given note and octave and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param note Note
          * @param octave Octave
          * @param t Time
          * @return The signal
          */
-        float play(float a, float note, double octave, double t);
+        float play(VoiceState &v, float a, float note, double octave, double t) const;
         /**
          * @brief Plays sounds when released at t time and rt release time with a given key and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param k Structure Key (note, octave)
          * @param t Time
          * @return The signal
          */
-        float play_key(float a, Key k, double t, double rt);
+        float play_key(VoiceState &v, float a, Key k, double t, double rt) const;
         /**
          * @brief Plays sounds when released at t time and rt release time with a given note and octave and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param note Note
          * @param octave Octave
@@ -373,72 +685,382 @@ namespace C0deTracker {
          * @param rt Release Time
          * @return The Signal
          */
-        float play(float a, float note, float octave, double t, double rt);
+        float play(VoiceState &v, float a, float note, float octave, double t, double rt) const;
 
         /**
          * @brief Plays sounds at t time with a given pitch and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param p Pitch
          * @param t Time
          * @return The Signal
          */
-        float play_pitch(float a, float p, double t);
+        float play_pitch(VoiceState &v, float a, float p, double t) const;
 
         /**
          * @brief Plays sounds when released at t and rt release time with a given pitch and amplitude
+         * @param v state of the voice played
          * @param a Amplitude
          * @param p Pitch
          * @param t Time
          * @return The Signal
          */
-        float play_pitch(float a, float p, double t, double rt);
+        float play_pitch(VoiceState &v, float a, float p, double t, double rt) const;
+
+        /**
+         * @brief Plays a block of samples with a given pitch and amplitude for each sample
+         * @param v state of the voice played
+         * @param out buffer receiving the n samples
+         * @param n number of samples
+         * @param a Amplitude of each sample
+         * @param p Pitch of each sample
+         * @param t Time of each sample
+         * @param rt Release time of each sample, negative while the note is not released
+         */
+        void play_pitch(VoiceState &v, float* out, size_t n, const float* a, const float* p, const double* t,
+                        const double* rt) const;
+
+        /**
+         * @brief Plays sounds at t time with a given frequency and amplitude
+         * @param v state of the voice played
+         * @param a Amplitude
+         * @param f Frequency
+         * @param t Time
+         * @return The Signal
+         */
+        float play_freq(VoiceState &v, float a, float f, double t) const;
+
+        /**
+         * @brief Plays sounds when released at t and rt release time with a given frequency and amplitude
+         * @param v state of the voice played
+         * @param a Amplitude
+         * @param f Frequency
+         * @param t Time
+         * @param rt Release Time
+         * @return The Signal
+         */
+        float play_freq(VoiceState &v, float a, float f, double t, double rt) const;
+
+        /**
+         * @brief Plays a block of samples with a given frequency and amplitude for each sample
+         * @param v state of the voice played
+         * @param out buffer receiving the n samples
+         * @param n number of samples
+         * @param a Amplitude of each sample
+         * @param f Frequency of each sample
+         * @param t Time of each sample
+         * @param rt Release time of each sample, negative while the note is not released
+         */
+        void play_freq(VoiceState &v, float* out, size_t n, const float* a, const float* f, const double* t,
+                       const double* rt) const;
+
+        /**
+         * @brief advances the instrument over a block of samples like play_freq would, without computing them
+         * @param v state of the voice played
+         * @param n number of samples
+         * @param f Frequency of each sample
+         * @param t Time of each sample
+         * @param rt Release time of each sample, negative while the note is not released
+         */
+        void skip(VoiceState &v, size_t n, const float* f, const double* t, const double* rt) const;
 
     private:
         float global_volume = 1.0f;
         Oscillator* osc = nullptr;
     };
 
+    /**
+     * @brief read-only instrument definition, shared by every channel, track and thread playing it. Once the bank is
+     * given to a track, its instruments are only seen through this const type, so their oscillators cannot be changed.
+     */
+    using InstrumentDef = const Instrument;
+
     /**
      * @brief Instruction structure represents the instruction you type to make your music (instrument index, volume, note,
      * effects). It should be written in Pattern structure.
+     * @details An instruction is one row of 32 bytes with its effects stored inline (fx_mask tells which columns are
+     * written), so the rows of a pattern are contiguous and reading a row touches a single cache line.
      *
      * @see Pattern
      */
-    struct Instruction{
-        uint_fast8_t instrument_index{}; Key key; float volume{}; uint_fast32_t** effects{};//effect tab
+    struct alignas(32) Instruction{
+        Key key; float volume{}; uint_fast8_t instrument_index{};
+        uint8_t fx_mask{};/**<bit i is set when effects[i] holds an effect*/
+        uint8_t reserved[2]{};//no padding in a row, rows are stored as they are in .ctk files
+        uint32_t effects[EFFECT_COLUMNS]{};//effect columns
         /**
          * @brief Default constructor to create empty instruction
          */
-        Instruction();
-        Instruction(uint_fast8_t instrument, Key k, float vol);
-        Instruction(uint_fast8_t instrument, float note, float octave, float vol);
-        Instruction(uint_fast8_t instrument, Key k, float vol, uint_fast32_t** effects);
-        Instruction(uint_fast8_t instrument, float note, float octave, float vol, uint_fast32_t** effects);
+        constexpr Instruction() : volume(Notes::CONTINUE), instrument_index(Notes::CONTINUE) {}
+        constexpr Instruction(uint_fast8_t instrument, Key k, float vol) : key(k), volume(vol), instrument_index(instrument) {}
+        constexpr Instruction(uint_fast8_t instrument, float note, float octave, float vol)
+                : key(note, octave), volume(vol), instrument_index(instrument) {}
+        Instruction(uint_fast8_t instrument, Key k, float vol, const std::vector<uint_fast32_t> &effects);
+        Instruction(uint_fast8_t instrument, float note, float octave, float vol, const std::vector<uint_fast32_t> &effects);
+
+        /**
+         * @brief writes an effect in a column, columns past EFFECT_COLUMNS are ignored
+         * @param column index of the effect column
+         * @param fx effect code
+         */
+        constexpr void setEffect(uint_fast8_t column, uint_fast32_t fx) {
+            if (column < EFFECT_COLUMNS) {
+                this->effects[column] = uint32_t(fx);
+                this->fx_mask |= uint8_t(1u << column);
+            }
+        }
+        /**
+         * @param column index of the effect column
+         * @return true if an effect is written in this column
+         */
+        constexpr bool hasEffect(uint_fast8_t column) const {
+            return column < EFFECT_COLUMNS && (this->fx_mask >> column & 1u);
+        }
         /**
-         * @brief Destructor.
+         * @brief removes every effect of the instruction
          */
-        ~Instruction();
+        constexpr void clearEffects() {
+            this->fx_mask = 0;
+            for (uint32_t &fx : this->effects) {
+                fx = 0;//rows without effects are identical, so identical patterns can be shared
+            }
+        }
     };
 
     /**
-     * @brief This structure contains the array of pointers of Instructions. Patterns are fed to the Track.
+     * @brief This structure contains the rows of a pattern, stored contiguously. Patterns are fed to the Track.
      * @see Instruction , Track
      */
     struct Pattern{
-        Instruction** instructions; /**<Array of Instruction pointers*/
+        Instruction* instructions; /**<Array of rows instructions*/
         uint_fast8_t rows; /**< Size of the row*/
-        uint_fast8_t n_fx;
+        uint_fast8_t n_fx;/**< Effects per instruction, at most EFFECT_COLUMNS*/
         /**
          * @brief Pattern initializer
          * @param rows size of the patterns
          * @param number_of_fx max fx supported in this pattern of a corresponding channel
          */
         Pattern(uint_fast8_t rows, uint_fast8_t number_of_fx);
+        /**
+         * @brief Pattern initializer using rows allocated by someone else (an Arena), they are not deleted with the
+         * pattern
+         * @param rows size of the patterns
+         * @param number_of_fx max fx supported in this pattern of a corresponding channel
+         * @param instructions array of rows empty instructions
+         */
+        Pattern(uint_fast8_t rows, uint_fast8_t number_of_fx, Instruction* instructions);
 
         /**
          * @brief Delete instructions dynamic allocation
          */
         ~Pattern();
+    private:
+        bool owns_instructions = true;
+    };
+
+    /**
+     * @brief An effect of a row decoded once when the track is built (see effects.txt for the codes). The parameters
+     * are already scaled, so playing the effect only copies them to the track or the channel.
+     * @see RowEvent
+     */
+    struct EffectCommand{
+        /**
+         * @brief the effects, numbered like their codes. Effects before CHANNEL_EFFECTS change the track, the others
+         * change the channel of the row.
+         */
+        enum Types{TRACK_PITCH_SLIDE_UP, TRACK_PITCH_SLIDE_DOWN, TRACK_VIBRATO, TRACK_PITCH, TRACK_VOLUME,
+                   TRACK_VOLUME_SLIDE_UP, TRACK_VOLUME_SLIDE_DOWN, TRACK_TREMOLO, TRACK_PANNING, TRACK_SPEED, JUMP, STOP,
+                   TRACK_PANNING_SLIDE_RIGHT = 0x0D, TRACK_PANNING_SLIDE_LEFT,
+                   CHANNEL_EFFECTS = 0x10,
+                   PITCH_SLIDE_UP = CHANNEL_EFFECTS, PITCH_SLIDE_DOWN, VIBRATO, PITCH, VOLUME, VOLUME_SLIDE_UP,
+                   VOLUME_SLIDE_DOWN, TREMOLO, PANNING, ARPEGGIO, TRANSPOSE, PORTAMENTO, RETRIEG, PANNING_SLIDE_RIGHT,
+                   PANNING_SLIDE_LEFT, DELAY_RELEASE};
+        uint8_t type;/**<one of Types*/
+        uint8_t args[6];/**<integer parameters : arpeggio semitones, delays, counts, frame and row of a jump*/
+        float x, y;/**<scaled parameters : rate, value, speed and depth, speed and step*/
+
+        /**
+         * @brief decodes an effect code of a row
+         * @param fx effect code, 8 bits of type then 24 bits of value
+         * @param command receives the decoded effect
+         * @return false if the code is not an effect C0deTracker plays, or a jump past frame or row 0xFF
+         */
+        static bool decode(uint_fast32_t fx, EffectCommand &command);
+    };
+
+    /**
+     * @brief A row of a pattern which does something to its channel, compiled once by the Track. Rows doing nothing
+     * (no instrument, no release, no volume, no effect) have no event, so the sequencer skips them without reading the
+     * pattern.
+     * @see Track
+     */
+    struct RowEvent{
+        /**
+         * @brief what the row does, several at once for a note with effects
+         */
+        enum Kinds{NOTE_ON = 1, NOTE_RELEASE = 2, VOLUME_CHANGE = 4, EFFECTS = 8};
+        uint_fast8_t row;/**<row of the pattern*/
+        uint_fast8_t kinds;/**<Kinds of the row*/
+        uint_fast8_t effects;/**<number of effect commands of the row*/
+        uint32_t first_effect;/**<index of the first effect command of the row in the commands of the track*/
+        Instruction* instruction;/**<the row itself*/
+    };
+
+    /**
+     * @brief Bump allocator holding the whole data of a song (patterns, rows, pattern indices) in a few big blocks.
+     * Nothing is freed before the arena itself, which releases everything at once and without calling destructors.
+     */
+    class Arena{
+    public:
+        /**
+         * @param capacity bytes reserved at once, the arena grows by ARENA_CHUNK_SIZE when it is full
+         */
+        explicit Arena(size_t capacity = ARENA_CHUNK_SIZE);
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /**
+         * @param size bytes to allocate
+         * @param alignment alignment of the block, a power of two
+         * @return uninitialized block living as long as the arena
+         */
+        void* allocate(size_t size, size_t alignment);
+
+        /**
+         * @brief builds an object in the arena, its destructor is never called
+         */
+        template<class T, class... Args> T* create(Args&&... args) {
+            return new(this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief builds n default constructed objects in the arena, their destructors are never called
+         */
+        template<class T> T* createArray(size_t n) {
+            T *array = static_cast<T*>(this->allocate(sizeof(T) * n, alignof(T)));
+            for (size_t i = 0; i < n; ++i) {
+                new(&array[i]) T();
+            }
+            return array;
+        }
+
+        /**
+         * @return true if p points into memory of this arena
+         */
+        bool contains(const void* p) const;
+
+        /**
+         * @return bytes handed out so far
+         */
+        size_t getUsed() const;
+
+        /**
+         * @return bytes reserved from the system
+         */
+        size_t getCapacity() const;
+    private:
+        struct Chunk{
+            char* data;
+            size_t size;
+        };
+        std::vector<Chunk> chunks;
+        size_t offset = 0;//first free byte of the last chunk
+        size_t used = 0;
+        size_t capacity = 0;
+
+        void grow(size_t size);
+    };
+
+    /**
+     * @brief Patterns of a song without their duplicates : patterns with the same rows are added once, whatever their
+     * channel, and the empty pattern is always the first one (EMPTY_PATTERN). The pool only points to the rows it is
+     * given, they must live as long as it.
+     */
+    class PatternPool{
+    public:
+        /**
+         * @param rows number of rows of every pattern of the song
+         */
+        explicit PatternPool(uint_fast8_t rows);
+        PatternPool(const PatternPool&) = delete;
+        PatternPool& operator=(const PatternPool&) = delete;
+
+        /**
+         * @param rows rows of a pattern
+         * @return index in the pool of a pattern having the same rows, the pattern is added if there is none
+         */
+        uint_fast16_t add(const Instruction* rows);
+
+        /**
+         * @return number of different patterns, the empty one included
+         */
+        uint_fast16_t size() const;
+
+        /**
+         * @return rows of the pattern at this index
+         */
+        const Instruction* getRows(uint_fast16_t index) const;
+
+    private:
+        uint_fast8_t rows;
+        std::vector<Instruction> empty;
+        std::vector<const Instruction*> patterns;
+        std::unordered_multimap<uint64_t, uint_fast16_t> hashes;//hash of the rows, index of the patterns having it
+
+        uint64_t hash(const Instruction* rows) const;
+    };
+
+    /**
+     * @brief Pool of threads running the same job on several indices, used by Track to render its channels at the same
+     * time. The calling thread works too, so a pool of n threads starts n - 1 workers.
+     */
+    class WorkerPool{
+    public:
+        /**
+         * @brief function run by the pool, receiving the context given to run and the index of the job
+         */
+        typedef void (*Job)(void* context, size_t index);
+
+        /**
+         * @brief starts the workers
+         * @param threads number of threads working on the jobs, including the one calling run
+         */
+        explicit WorkerPool(unsigned threads);
+
+        /**
+         * @brief stops and joins the workers
+         */
+        ~WorkerPool();
+
+        /**
+         * @brief runs job(context, i) for i from 0 to jobs - 1 and returns once all of them are done
+         * @param jobs number of jobs
+         * @param job function to run
+         * @param context pointer given to each call of job
+         * @note The jobs can run in any order and on any thread, they must not depend on each other.
+         */
+        void run(size_t jobs, Job job, void* context);
+
+        /**
+         * @return number of threads working on the jobs, including the one calling run
+         */
+        unsigned getThreads() const;
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake, finished;
+        Job job = nullptr;
+        void* context = nullptr;
+        size_t jobs = 0;
+        std::atomic<size_t> next{0};
+        size_t pending = 0;//jobs not finished yet
+        unsigned busy = 0;//workers inside the current run
+        uint_fast64_t generation = 0;
+        bool quit = false;
+        void work();
+        void take(Job job, void* context, size_t jobs);
     };
 
     /**
@@ -464,6 +1086,26 @@ namespace C0deTracker {
         Track(float clk, float basetime, float speed, uint_fast8_t rows, uint_fast8_t frames, uint_fast8_t channels,
               Instrument** instruments_bank, uint_fast8_t numb_of_instruments, Pattern** track_patterns, uint_fast8_t** pattern_indices,
               const uint_fast8_t* effects_per_chan);
+        /**
+         * @brief Track playing read-only song data (a constexpr SongData, a mapped .ctk file). Only the patterns around
+         * the rows and the pointers to the indices are created, the data itself is never copied nor written.
+         * @param clk Clock frequency in Hz (60 in NTSC, 50 in PAL)
+         * @param basetime the base time of the track, it multiplies the speed
+         * @param speed the speed of the track, the tempo = speed * basetime / clk
+         * @param rows Size of a pattern. Number of instructions in each pattern
+         * @param frames Number of patterns
+         * @param channels Number of channel related to polyphony
+         * @param instruments_bank Pointer to the array containing the pointers to instruments, deleted with the track
+         * @param numb_of_instruments Size of instruments_bank
+         * @param song_rows rows of the patterns, pattern after pattern
+         * @param slots pattern of song_rows used by each channel * frames + pattern, nullptr if song_rows holds the
+         * channels * frames patterns in this order
+         * @param order pattern index of each channel for each frame (channel * frames + frame)
+         * @param effects_per_chan number of effects of each channel
+         */
+        Track(float clk, float basetime, float speed, uint_fast8_t rows, uint_fast8_t frames, uint_fast8_t channels,
+              Instrument** instruments_bank, uint_fast8_t numb_of_instruments, const Instruction* song_rows,
+              const uint16_t* slots, const uint_fast8_t* order, const uint_fast8_t* effects_per_chan);
         /**
          * @brief free everything related to the track, patterns, patterns indices, instruments
          */
@@ -478,6 +1120,98 @@ namespace C0deTracker {
          */
         float* play(double t, Channel* chan, uint_fast8_t size_of_chans);
 
+        /**
+         * @brief renders a whole block of stereo samples in one call. Rows are read once when they start, then each
+         * channel is rendered over the samples until the next row before being mixed in the stereo bus.
+         * @param out buffer owned by the caller, of at least 2 * frames floats
+         * @param frames number of stereo samples to render
+         * @param t time in second of the first sample of the block
+         * @param sample_rate sample rate in Hz, sample n of the block is rendered at t + n / sample_rate
+         * @param chan pointers to the channels allocated dynamically by the user
+         * @param size_of_chans number of channels created by the user, otherwise the size of the array chan
+         * @param planar false to interleave left and right samples (LRLR...), true to write all left samples then all
+         * right samples
+         * @note Effects are evaluated at the control rate (see setControlPeriod) and interpolated sample by sample in
+         * between, rows and tick effects (arpeggio, retrieg, delay, release, portamento, transpose) stay sample accurate.
+         */
+        void render(float* out, size_t frames, double t, double sample_rate, Channel* chan, uint_fast8_t size_of_chans,
+                    bool planar = false);
+
+        /**
+         * @brief sets how often render evaluates the effects (slides, vibrato, tremolo)
+         * @param samples number of samples between two evaluations, 0 (default) to evaluate them once per tick
+         * (sample rate / clock), 1 to evaluate them at each sample like play does
+         */
+        void setControlPeriod(uint_fast32_t samples);
+
+        /**
+         * @return number of samples between two evaluations of the effects, 0 means once per tick
+         */
+        uint_fast32_t getControlPeriod();
+
+        /**
+         * @brief sets how many threads render renders the channels with. Rows and track effects are still read by
+         * the calling thread and channels are mixed in the same order, so the samples are exactly the same as with
+         * a single thread.
+         * @param threads number of threads including the calling one, 0 or 1 (default) to render on the calling thread
+         * only. std::thread::hardware_concurrency() is a good value for offline rendering.
+         */
+        void setRenderThreads(unsigned threads);
+
+        /**
+         * @return number of threads rendering the channels
+         */
+        unsigned getRenderThreads();
+
+        /**
+         * @brief makes render copy the sequencer and the channels at the start of a row every rows rows, so that seek
+         * only has to replay the song from the closest copy. The copies are taken while the song plays for the first
+         * time (or by buildCheckpoints).
+         * @param rows number of rows between two checkpoints, 0 (default) to take none
+         */
+        void setCheckpointInterval(uint_fast32_t rows);
+
+        /**
+         * @return number of rows between two checkpoints, 0 if they are disabled
+         */
+        uint_fast32_t getCheckpointInterval();
+
+        /**
+         * @brief takes the checkpoints of the beginning of the song at once, without producing sound, instead of
+         * waiting for the song to be played. Replaces the checkpoints already taken.
+         * @param seconds length of the song to index
+         * @param sample_rate sample rate the song will be played at
+         * @note Uses CHECKPOINT_ROWS rows between two checkpoints if setCheckpointInterval was not called. The copied
+         * channels are numbered from 0 like the channels of exportSong.
+         */
+        void buildCheckpoints(double seconds, double sample_rate);
+
+        /**
+         * @brief moves the song to time t : the sequencer and the channels are restored from the closest checkpoint
+         * before t (or the beginning of the song) and the remaining rows are replayed without producing sound. The
+         * next call to render at time t goes on as if the song had been played until t.
+         * @param t time in second to go to
+         * @param sample_rate sample rate of the song
+         * @param chan pointers to the channels allocated dynamically by the user
+         * @param size_of_chans number of channels created by the user, otherwise the size of the array chan
+         * @note A render starting at t reads its samples at t + k / sample_rate, which can round differently from the
+         * times of a render started earlier, so the envelopes may differ in their last bits (checkpoints or not).
+         */
+        void seek(double t, double sample_rate, Channel* chan, uint_fast8_t size_of_chans);
+
+        /**
+         * @brief renders the song from its beginning for offline export, on several threads. The sequencer runs ahead
+         * without producing sound and copies its state and the channels at the start of a row every frames / (4 *
+         * threads) samples or so. Each part between two copies is rendered as soon as its copy is made.
+         * @param out buffer owned by the caller, of at least 2 * frames floats, receiving interleaved stereo samples
+         * @param frames number of stereo samples to render
+         * @param sample_rate sample rate in Hz
+         * @param threads number of threads rendering the parts, including the calling one
+         * @note The samples are exactly the ones render(out, frames, 0, sample_rate, chan, getNumberofChannels()) gives
+         * with new channels, numbered from 0. The track itself is left untouched.
+         */
+        void exportSong(float* out, size_t frames, double sample_rate, unsigned threads);
+
         /**
          * @return global panning if the track
          * @brief 0.5 is centered ; 0 sound is only on left ; 1 only on right
@@ -504,52 +1238,152 @@ namespace C0deTracker {
          */
         float getDuration();
 
+        /**
+         * @brief everything the sequencer changes while the song plays (position, speed and track effects). Restoring
+         * a state and the channels copied at the same moment gives back the exact same samples.
+         * @see getState, setState, Channel::restore
+         */
+        struct State{
+            float speed, step;
+            float duration;
+            float volume = 1.0f, pitch = 0.0f;
+            uint_fast8_t row_counter = 0, frame_counter = 0;
+            double time_advance = 0.0;
+            double time = 0.0;
+            bool readFx = true;
+
+            float volume_slide_up = 0.f;
+            float volume_slide_down = 0.f;
+            double volume_slide_time = 0.0;
+
+            float pitch_slide_up = 0.f;
+            float pitch_slide_down = 0.f;
+            double pitch_slide_time = 0.0;
+
+            float tremolo_speed = 0.0f;
+            float tremolo_depth = 0.0f;
+            float tremolo_val = 1.0f;
+            double tremolo_time = 0.0;
+
+            float vibrato_speed = 0.0f;
+            float vibrato_depth = 0.0f;
+            float vibrato_val = 0.0f;
+            double vibrato_time = 0.0;
+            float panning = 0.5f;
+            bool branch = false;
+            uint_fast8_t frametojump = 0;
+            uint_fast8_t rowtojump = 0;
+
+            bool stop = false;
+
+            float panning_slide_right = 0.f;
+            float panning_slide_left = 0.f;
+            double panning_slide_time = 0.0;
+        };
+
+        /**
+         * @return the current state of the sequencer
+         */
+        const State &getState() const;
+
+        /**
+         * @brief puts the sequencer back in a state given by getState
+         * @param state state to restore
+         */
+        void setState(const State &state);
+
     private:
-        float clk , basetime, speed, step;
+        float clk , basetime;
         uint_fast8_t  rows, frames;
         uint_fast8_t channels;
-        float volume = 1.0f, pitch = 0.0f;
-        Instrument** instruments_bank;
+        InstrumentDef* const* instruments_bank;//read-only once given to the track
         uint_fast8_t instruments;
         Pattern** track_patterns;
         uint_fast8_t** pattern_indices;//new uint_8[channels*frames]
-        float duration;
         const uint_fast8_t *fx_per_chan;
+        bool owns_song = true;//false for the copies made by exportSong, which share the song of the original
+        Arena* arena = nullptr;//patterns and indices written with the Editor, freed at once
+        SongFile* file = nullptr;//mapped .ctk file the rows and indices are read from
+        friend class SongFile;//builds tracks from files and writes them
 
-        uint_fast8_t row_counter = 0, frame_counter = 0;
-        double time_advance = 0.0;
-        double time = 0.0;
+        State state, beginning;//beginning is the state when the song starts
 
-        bool decode_fx(uint_fast32_t fx, double t);
-        bool readFx = true;
-        float volume_slide_up = 0.f;
-        float volume_slide_down = 0.f;
-        double volume_slide_time = 0.0;
+        Track(const Track &song);//a new sequencer at the beginning of the same song
 
-        float pitch_slide_up = 0.f;
-        float pitch_slide_down = 0.f;
-        double pitch_slide_time = 0.0;
-
-        float tremolo_speed = 0.0f;
-        float tremolo_depth = 0.0f;
-        float tremolo_val = 1.0f;
-        double tremolo_time = 0.0;
-
-        float vibrato_speed = 0.0f;
-        float vibrato_depth = 0.0f;
-        float vibrato_val = 0.0f;
-        double vibrato_time = 0.0;
-        float panning = 0.5f;
-        bool branch = false;
-        uint_fast8_t frametojump = 0;
-        uint_fast8_t rowtojump = 0;
+        /**
+         * @brief moves the patterns played by the song to a new arena, each different pattern once, and frees the arena
+         * they were written in. Patterns never played are replaced by the empty pattern.
+         * @param written arena of the Editor holding the patterns, the rows and the indices
+         */
+        void sharePatterns(Arena* written);
 
-        bool stop = false;
+        /**Row events**/
+        struct Span{//events of a pattern in the timeline, from begin to end excluded
+            uint_fast32_t begin, end;
+        };
+        std::vector<RowEvent> timeline;//events of every different pattern, sorted by row for each pattern
+        std::vector<EffectCommand> commands;//effects of the events, in the order they are played
+        std::vector<Span> spans;//events of the pattern of each channel * frames + pattern
+        /**
+         * @brief compiles the rows of the patterns into the timeline, each pattern once however many slots share it.
+         * Effects are decoded there, the unknown ones are reported on stderr and left out, like the columns past
+         * EFFECT_COLUMNS.
+         */
+        void compileTimeline();
+        /**
+         * @return event of the current row for the channel, nullptr if the row does nothing
+         */
+        const RowEvent* rowEvent(Channel &c);
 
-        float panning_slide_right = 0.f;
-        float panning_slide_left = 0.f;
-        double panning_slide_time = 0.0;
+        void applyEffect(const EffectCommand &fx, double t);
         void update_fx(double t);
+
+        /**Block rendering**/
+        std::vector<float> chan_buffer;//left and right samples of each channel for the current segment
+        std::vector<bool> active;//channels contributing to the mix in the current segment
+        float frame_pitch[RENDER_BLOCK_SIZE]{};//track pitch with vibrato
+        float frame_gain[RENDER_BLOCK_SIZE]{}, frame_panning[RENDER_BLOCK_SIZE]{};
+        uint_fast32_t control_period = 0;
+        size_t renderSegment(float* out, size_t frames, size_t done, double t, size_t first, double sample_rate,
+                             Channel* chan, uint_fast8_t n_of_chans, bool planar);
+        void renderFrom(float* out, size_t frames, double t, size_t first, double sample_rate, Channel* chan,
+                        uint_fast8_t size_of_chans, bool planar);
+        static void exportJob(void* exporter, size_t i);
+        bool rowStarts(size_t at, size_t target, double sample_rate) const;
+        bool advance(double t);
+        void readRow(Channel &c, double t);
+        void modulate(double t, uint_fast32_t samples, double dt);
+        struct Voice{//per channel values of the segment, so that channels can be rendered at the same time
+            float amp[RENDER_BLOCK_SIZE], pitch[RENDER_BLOCK_SIZE], panning[RENDER_BLOCK_SIZE];
+            double time[RENDER_BLOCK_SIZE], release_time[RENDER_BLOCK_SIZE];
+            float freq[RENDER_BLOCK_SIZE], out[RENDER_BLOCK_SIZE];
+            bool audible;//false if the channel adds nothing to the mix of the segment
+        };
+        std::vector<Voice> voices;
+        WorkerPool* pool = nullptr;
+        bool dry = false;//renderSegment runs the sequencer and the phases only, without oscillators nor mix
+        struct Checkpoint{//copy of the sequencer and the channels at the start of a row
+            double time;
+            State state;
+            std::vector<Channel> channels;
+        };
+        std::vector<Checkpoint> checkpoints;//sorted by time
+        double checkpoint_rate = 0.;//sample rate of the checkpoints
+        uint_fast32_t checkpoint_rows = 0, rows_since_checkpoint = 0;
+        void recordCheckpoint(double t, double sample_rate, Channel* chan, uint_fast8_t n_of_chans);
+        struct Segment{//what the channel jobs of the pool need to know about the segment
+            Track* track; Channel* chan; size_t at, len, period; double t, sample_rate;
+        };
+        static void renderChannelJob(void* segment, size_t i);
+        void renderChannel(Channel &c, uint_fast8_t i, size_t at, size_t len, double t, double sample_rate,
+                           size_t period);
+        void controlChannel(Channel &c, Voice &v, size_t at, size_t len, double t, double sample_rate, size_t period);
+        float playChannel(Channel &c, double t, float track_pitch);
+        float voiceAmplitude(const Channel &c);
+        float voiceBasePitch(const Channel &c);
+        float voiceModulation(const Channel &c);
+        float voiceFrequency(Channel &c, float p);
+        void voiceFrequencies(Channel &c, Voice &v, size_t from, size_t n);
     };
 
     /**
@@ -684,7 +1518,15 @@ namespace C0deTracker {
          */
         void setVolumeInstructionState(float a);
 
-        friend float* Track::play(double t, C0deTracker::Channel *chan, uint_fast8_t size_of_chans);//function play of Track friend of Channel in order to avoid creating a huge amount of getters for each attributes
+        /**
+         * @brief copies the playback state of another channel, its voice included, so that this channel plays
+         * exactly what the other one would play from now on. The number of the channel and whether it is enabled are
+         * kept.
+         * @param other channel to copy, playing the same track
+         */
+        void restore(const Channel &other);
+
+        friend class Track;//Track reads and writes the channel state in order to avoid creating a huge amount of getters for each attributes
     private:
         static uint_fast8_t chancount;
         Instruction* last_instruct_address = nullptr;
@@ -698,9 +1540,12 @@ namespace C0deTracker {
         bool released = false;
         double time_release = 0.0;
         Instruction instruct_state{};
-        Instrument* instrument = nullptr;
+        const InstrumentDef* instrument = nullptr;//instrument of the bank played, never modified by the channel
+        VoiceState voice;//state of the note played with it
+        uint_fast32_t next_event = 0;//index in the timeline of the track of the next row event to read
+        void selectInstrument(const InstrumentDef* def);//plays an instrument from a new voice
 
-        bool decode_fx(uint_fast32_t fx, double t);
+        void applyEffect(const EffectCommand &fx, double t);
 
         float volume_slide_up = 0.f;
         float volume_slide_down = 0.f;
@@ -717,6 +1562,9 @@ namespace C0deTracker {
         float porta_pitch_dif = 0.0f;
         double portamento_time_step = 0;
 
+        float cached_pitch = NAN;//last pitch converted in frequency, so that held notes skip the conversion
+        float cached_freq = 0.f;
+
         float tremolo_speed = 0.0f;
         float tremolo_depth = 0.0f;
         float tremolo_val = 1.0f;
@@ -739,6 +1587,11 @@ namespace C0deTracker {
         uint_fast8_t arpeggio_val[6]{};
 
         void update_fx(double t);
+        void modulate(double t, uint_fast32_t samples, double dt);//slides, vibrato and tremolo
+        void tick(double t);//arpeggio, transpose, retrieg, delay, release and portamento
+        bool tickDue(double t) const;
+        bool hasTickEffects() const;
+        bool isDelaying() const;
 
         uint_fast8_t transpose_delay = 0;
         uint_fast8_t n_time_to_transpose = 0;
@@ -768,7 +1621,15 @@ namespace C0deTracker {
      */
     class Editor{
     public:
+        /**
+         * @brief starts a new song, the patterns and pattern indices loaded next are allocated in an Arena which the
+         * Track built with them takes over
+         */
         static void loadTrackProperties(uint_fast8_t number_of_rows, uint_fast8_t number_of_frames, uint_fast8_t number_of_channels, const uint_fast8_t *effects_per_chan);
+        /**
+         * @return channels * frames patterns which all point to the same empty pattern, a pattern gets its own rows
+         * when one of them is written. The track built with them keeps the patterns played, without duplicates.
+         */
         static Pattern** loadEmptyPatterns();
         static void prepare(Pattern **p, uint_fast8_t chanindx,  uint_fast8_t patternindx, uint_fast8_t instrumentnindx, float volume);
         static void prepare(uint_fast8_t chanindx, uint_fast8_t patternindx, uint_fast8_t instrumentnindx, float volume);
@@ -823,6 +1684,31 @@ namespace C0deTracker {
         static void enterPatternIndice(uint_fast8_t channel, uint_fast8_t frame, uint_fast8_t pattern_indice);
 
     private:
+        /**
+         * @brief replaces the effects of an instruction of the current pattern, the effects are copied in the row
+         * @param instruction_index row of the instruction
+         * @param effects array of the effects of the channel (one cell per effect of effects_per_chan), null cells are
+         * empty columns and the cells past EFFECT_COLUMNS are dropped. The array and all its cells are deleted
+         */
+        static void storeEffects(uint_fast8_t instruction_index, uint_fast32_t** effects);
+        static void storeEffects(uint_fast8_t instruction_index, const std::vector<uint_fast32_t> &effects);
+        static void storeEffects(uint_fast8_t instruction_index, uint_fast32_t effect);
+
+        /**
+         * @return arena of the song being written, created with the size of its pattern and index tables, the rows are
+         * added as the patterns are written
+         */
+        static Arena* songArena();
+
+        /**
+         * @return pattern being written, its rows are allocated when the first one is written
+         */
+        static Pattern* current();
+
+        friend class Track;//the track takes the arena holding its patterns
+
+        static Arena* arena;
+        static Pattern* empty;//every pattern of the song until it is written
         static Pattern **pattern;
         static uint_fast8_t** pattern_indices;
         static uint_fast8_t chan_index, pattern_index, instrument_index, frames;
@@ -832,6 +1718,348 @@ namespace C0deTracker {
         static const uint_fast8_t *fx_per_chan;
     };
 
+    /**
+     * @brief Compile-time counterpart of the Editor. A song written with a constexpr SongData is a constant table of
+     * rows and pattern indices stored in read-only data, and creating its track only wraps pointers around them.
+     * @details Same calls as the Editor (store*, enterInstruction, release, enterPatternIndice) in a constexpr
+     * function or lambda, e.g. static constexpr auto SONG = []{ SongData<ROWS, FRAMES, CHANNELS> s(fx_per_chan); ...
+     * return s; }(); Effects lists are given as {fx1, fx2}.
+     * @tparam ROWS Size of a pattern
+     * @tparam FRAMES Number of patterns
+     * @tparam CHANNELS Number of channels
+     */
+    template<uint_fast8_t ROWS, uint_fast8_t FRAMES, uint_fast8_t CHANNELS>
+    class SongData{
+    public:
+        /**
+         * @param effects_per_chan number of effects of each channel, at most EFFECT_COLUMNS are kept
+         */
+        constexpr explicit SongData(const uint_fast8_t (&effects_per_chan)[CHANNELS]) {
+            for (uint_fast8_t c = 0; c < CHANNELS; ++c) {
+                this->fx_per_chan[c] = effects_per_chan[c];
+                for (uint_fast8_t f = 0; f < FRAMES; ++f) {
+                    this->order[c * FRAMES + f] = f;
+                }
+            }
+        }
+
+        constexpr void storeChannelIndex(uint_fast8_t chanindx) { this->chan_index = chanindx; }
+        constexpr void storePatternIndex(uint_fast8_t patternindx) {
+            if (patternindx < FRAMES) {
+                this->pattern_index = patternindx;
+            }
+        }
+        constexpr void storeInstrumentIndex(uint_fast8_t instrumentnindx) { this->instrument_index = instrumentnindx; }
+        constexpr void storeVolume(float volume) { this->volume = volume; }
+
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, this->volume);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key) {
+            this->enterInstruction(instruction_index, instrument_index, key, this->volume);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key, float volume) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, volume);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key,
+                                        float volume) {
+            if (instruction_index < ROWS) {
+                Instruction &row = this->row(instruction_index);
+                row.instrument_index = instrument_index;
+                row.volume = volume;
+                row.key = key;
+            }
+        }
+
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key, std::initializer_list<uint_fast32_t> effects) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, this->volume, effects);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key, uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, this->volume, {effect});
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key,
+                                        std::initializer_list<uint_fast32_t> effects) {
+            this->enterInstruction(instruction_index, instrument_index, key, this->volume, effects);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key,
+                                        uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, instrument_index, key, this->volume, {effect});
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key, float volume,
+                                        std::initializer_list<uint_fast32_t> effects) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, volume, effects);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, Key key, float volume, uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, this->instrument_index, key, volume, {effect});
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key,
+                                        float volume, std::initializer_list<uint_fast32_t> effects) {
+            if (instruction_index < ROWS) {
+                this->enterInstruction(instruction_index, instrument_index, key, volume);
+                this->storeEffects(instruction_index, effects);
+            }
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, Key key,
+                                        float volume, uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, instrument_index, key, volume, {effect});
+        }
+
+        constexpr void enterInstruction(uint_fast8_t instruction_index, float volume) {
+            if (instruction_index < ROWS) {
+                this->row(instruction_index).volume = volume;
+            }
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, std::initializer_list<uint_fast32_t> effects) {
+            if (instruction_index < ROWS) {
+                this->storeEffects(instruction_index, effects);
+            }
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, float volume,
+                                        std::initializer_list<uint_fast32_t> effects) {
+            this->enterInstruction(instruction_index, volume);
+            this->enterInstruction(instruction_index, effects);
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, {effect});
+        }
+        constexpr void enterInstruction(uint_fast8_t instruction_index, float volume, uint_fast32_t effect) {
+            this->enterInstruction(instruction_index, volume, {effect});
+        }
+
+        constexpr void release(uint_fast8_t instruction_index) {
+            if (instruction_index < ROWS) {
+                this->row(instruction_index).instrument_index = Notes::RELEASE;
+            }
+        }
+        constexpr void release(uint_fast8_t instruction_index, float volume) {
+            if (instruction_index < ROWS) {
+                this->row(instruction_index).instrument_index = Notes::RELEASE;
+                this->row(instruction_index).volume = volume;
+            }
+        }
+        constexpr void release(uint_fast8_t instruction_index, std::initializer_list<uint_fast32_t> effects) {
+            if (instruction_index < ROWS) {
+                this->row(instruction_index).instrument_index = Notes::RELEASE;
+                this->storeEffects(instruction_index, effects);
+            }
+        }
+        constexpr void release(uint_fast8_t instruction_index, float volume, std::initializer_list<uint_fast32_t> effects) {
+            this->release(instruction_index, volume);
+            this->release(instruction_index, effects);
+        }
+        constexpr void release(uint_fast8_t instruction_index, uint_fast32_t effect) {
+            this->release(instruction_index, {effect});
+        }
+        constexpr void release(uint_fast8_t instruction_index, float volume, uint_fast32_t effect) {
+            this->release(instruction_index, volume, {effect});
+        }
+
+        constexpr void enterPatternIndice(uint_fast8_t channel, uint_fast8_t frame, uint_fast8_t pattern_indice) {
+            this->order[channel * FRAMES + frame] = pattern_indice;
+        }
+
+        /**
+         * @brief creates a track playing the song straight from this table, which must outlive the track (a static
+         * constexpr SongData does)
+         * @param clk Clock frequency in Hz (60 in NTSC, 50 in PAL)
+         * @param basetime the base time of the track, it multiplies the speed
+         * @param speed the speed of the track, the tempo = speed * basetime / clk
+         * @param instruments_bank Pointer to the array containing the pointers to instruments, deleted with the track
+         * @param numb_of_instruments Size of instruments_bank
+         */
+        Track* createTrack(float clk, float basetime, float speed, Instrument** instruments_bank,
+                           uint_fast8_t numb_of_instruments) const {
+            return new Track(clk, basetime, speed, ROWS, FRAMES, CHANNELS, instruments_bank, numb_of_instruments,
+                             this->rows, nullptr, this->order, this->fx_per_chan);
+        }
+
+    private:
+        Instruction rows[CHANNELS * FRAMES * ROWS]{};//channel * frames + pattern, then row
+        uint_fast8_t order[CHANNELS * FRAMES]{};
+        uint_fast8_t fx_per_chan[CHANNELS]{};
+        uint_fast8_t chan_index = 0, pattern_index = 0, instrument_index = 0;
+        float volume = 0;
+
+        constexpr Instruction& row(uint_fast8_t instruction_index) {
+            return this->rows[(this->chan_index * FRAMES + this->pattern_index) * ROWS + instruction_index];
+        }
+
+        constexpr void storeEffects(uint_fast8_t instruction_index, std::initializer_list<uint_fast32_t> effects) {
+            Instruction &row = this->row(instruction_index);
+            row.clearEffects();
+            uint_fast8_t column = 0;
+            for (uint_fast32_t fx : effects) {
+                if (column < this->fx_per_chan[this->chan_index]) {
+                    row.setEffect(column, fx);
+                }
+                ++column;
+            }
+        }
+    };
+
+    /**
+     * @brief Binary .ctk song file. A file holds the instruments, the effects per channel, the order list (pattern
+     * index of each channel for each frame) and the rows of every different pattern in the Instruction layout, so a
+     * loaded track plays straight from the mapped pages: only the instruments and a table of pattern pointers are built.
+     * @details Layout (native byte order, checked on load) : header, instruments, effects per channel, order list,
+     * pattern of the pool used by each channel * frames + pattern (16 bits, patterns never played use the empty one),
+     * then the rows of the pool aligned on 64 bytes, pattern after pattern, starting with the empty pattern. The
+     * header stores CTK_VERSION and the size of a row, a file written by another version is refused, except version 2
+     * files (before the ADSR curves) whose envelopes are played linear.
+     * @see PatternPool
+     */
+    class SongFile{
+    public:
+        /**
+         * @brief maps a .ctk file and builds a track playing it, the file stays mapped until the track is deleted.
+         * The patterns of the track are read-only, they must not be given to the Editor.
+         * @param path path of the file
+         * @return the track, nullptr if the file cannot be read or is not a valid .ctk file of this version or of
+         * version 2 (the reason is printed on stderr)
+         */
+        static Track* load(const char* path);
+
+        /**
+         * @brief writes a track to a .ctk file, as it is before being played
+         * @param track track to write, its instruments must use PSG or BandLimitedPSG oscillators
+         * @param path path of the file
+         * @return false if the track cannot be stored or the file cannot be written
+         * @note A file only stores the parameters of PSG oscillators, not the samples of a table : a track with a
+         * Wavetable instrument is refused and the instrument is named on stderr.
+         */
+        static bool save(Track& track, const char* path);
+
+        ~SongFile();
+        SongFile(const SongFile&) = delete;
+        SongFile& operator=(const SongFile&) = delete;
+    private:
+        explicit SongFile(const char* path);
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Wait-free buffer of floats between one producer thread and one consumer thread. Neither side ever locks
+     * nor waits for the other one, so the consumer can be an audio callback.
+     */
+    class RingBuffer{
+    public:
+        /**
+         * @brief allocates the buffer
+         * @param capacity number of floats the buffer can hold, rounded up to a power of two
+         */
+        explicit RingBuffer(size_t capacity);
+
+        /**
+         * @brief producer side, copies as many floats as there is room for
+         * @param data floats to copy
+         * @param n number of floats to copy
+         * @return number of floats copied
+         */
+        size_t write(const float* data, size_t n);
+
+        /**
+         * @brief consumer side, copies as many floats as are available
+         * @param data buffer receiving the floats
+         * @param n number of floats wanted
+         * @return number of floats copied
+         */
+        size_t read(float* data, size_t n);
+
+        /**
+         * @return number of floats the consumer can read
+         */
+        size_t available() const;
+
+        /**
+         * @return number of floats the producer can write
+         */
+        size_t space() const;
+
+        /**
+         * @brief empties the buffer
+         * @note Neither the producer nor the consumer must be using the buffer.
+         */
+        void clear();
+
+    private:
+        std::vector<float> buffer;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0};//written by the producer
+        alignas(64) std::atomic<size_t> tail{0};//written by the consumer
+    };
+
+    /**
+     * @brief Renders a track on its own thread into a RingBuffer, a look-ahead ahead of what is played. The audio
+     * callback only copies the samples out with pull, so that it never waits for the synthesis.
+     */
+    class RenderThread{
+    public:
+        /**
+         * @param track track to render
+         * @param chan pointers to the channels allocated dynamically by the user
+         * @param size_of_chans number of channels created by the user, otherwise the size of the array chan
+         * @param sample_rate sample rate in Hz
+         * @param lookahead number of stereo samples rendered in advance
+         */
+        RenderThread(Track* track, Channel* chan, uint_fast8_t size_of_chans, double sample_rate, size_t lookahead);
+
+        /**
+         * @brief stops the thread
+         */
+        ~RenderThread();
+
+        /**
+         * @brief starts rendering the track from time t
+         * @param t time in second
+         */
+        void start(double t);
+
+        /**
+         * @brief stops rendering, the samples not pulled yet are dropped
+         */
+        void stop();
+
+        /**
+         * @brief stops rendering, moves the track to time t (see Track::seek) and starts again from there
+         * @param t time in second
+         */
+        void seek(double t);
+
+        /**
+         * @brief consumer side, copies the next stereo samples (interleaved) out of the ring buffer. Missing samples
+         * are replaced by silence and counted as underruns.
+         * @param out buffer receiving 2 * frames floats
+         * @param frames number of stereo samples wanted
+         * @return number of stereo samples that were rendered in time
+         */
+        size_t pull(float* out, size_t frames);
+
+        /**
+         * @brief changes how far ahead the thread renders
+         * @param frames number of stereo samples, up to the look-ahead given to the constructor
+         */
+        void setLookahead(size_t frames);
+
+        /**
+         * @return number of stereo samples replaced by silence since the beginning because they were not ready
+         */
+        size_t getUnderruns() const;
+
+    private:
+        Track* track;
+        Channel* chan;
+        uint_fast8_t size_of_chans;
+        double sample_rate;
+        RingBuffer ring;
+        size_t max_lookahead;
+        std::atomic<size_t> lookahead;
+        std::atomic<size_t> underruns{0};
+        std::atomic<bool> running{false};
+        std::thread thread;
+        double start_time = 0.;
+        void work();
+    };
 
 }
 
@@ -0,0 +1,32 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#ifndef C0DETRACKER_CATALOG_HPP
+#define C0DETRACKER_CATALOG_HPP
+#include "examples.hpp"
+#include "tutorial.hpp"
+
+namespace catalog{
+    /**
+     * @brief a song written with the Editor, as the tools (benchmark, exporter) see it
+     */
+    struct Song{
+        const char* name;
+        C0deTracker::Track* (*init_track)();
+        uint_fast8_t channels;
+    };
+
+    const Song SONGS[] = {
+            {"ssf2_credit_theme", ssf2_credit_theme::init_track, ssf2_credit_theme::CHANNELS},
+            {"frere_jacques", frere_jacques::init_track, frere_jacques::CHANNELS},
+            {"fzero_intro", fzero_intro::init_track, fzero_intro::CHANNELS},
+            {"smb1_overworld", smb1_overworld::init_track, smb1_overworld::CHANNELS},
+            {"kirbys_dreamland_greengreens", kirbys_dreamland_greengreens::init_track, kirbys_dreamland_greengreens::CHANNELS},
+            {"sonic_green_hill_zone", sonic_green_hill_zone::init_track, sonic_green_hill_zone::CHANNELS},
+            {"my_song", my_song::init_track, my_song::CHANNELS},
+    };
+    const size_t SIZE_OF_SONGS = sizeof(SONGS) / sizeof(SONGS[0]);
+}
+
+#endif //C0DETRACKER_CATALOG_HPP
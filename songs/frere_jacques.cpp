@@ -4,28 +4,20 @@
 #include "examples.hpp"
 
 namespace frere_jacques{
-    C0deTracker::Track* init_track(){
-        auto** instruments_bank = new C0deTracker::Instrument*[INSTRUMENTS];
-        instruments_bank[MAIN] = new C0deTracker::Instrument(new C0deTracker::PSG(C0deTracker::TRIANGLE,1.f, 0.5f, C0deTracker::ADSR(4.66f,2.f,0.5f,4.f)), 0.6f);
-        instruments_bank[BASS] = new C0deTracker::Instrument(new C0deTracker::PSG(C0deTracker::SINUS, .5f, 0.f, C0deTracker::ADSR(1000.0f, 2.f, 0.2f, 5.33f)), 1.f);
+    //the song is written at compile time into read-only data, creating the track only wraps it
+    static constexpr C0deTracker::SongData<ROWS, FRAMES, CHANNELS> SONG = []{
+        C0deTracker::SongData<ROWS, FRAMES, CHANNELS> song(fx_per_chan);
 
-        using C0deTracker::Editor;
         using C0deTracker::Key;
         using namespace C0deTracker::Notes;
 
-        Editor::loadTrackProperties(ROWS, FRAMES, CHANNELS, fx_per_chan); //Load track propreties in the editor
-        auto** patterns = Editor::loadEmptyPatterns(); //generate empty patterns for song writing
-        auto** pattern_indices = Editor::loadEmptyPatternsIndices(); //generate empty patterns indices for patterns indexing
-        Editor::storePatterns(patterns); // store patterns in editor
-        Editor::storePatternsIndices(pattern_indices); // store pattern indices in editor
-
-#define VOLM Editor::storeVolume
-#define CHANL Editor::storeChannelIndex
-#define PATRN Editor::storePatternIndex
-#define INSTR Editor::storeInstrumentIndex
-#define I Editor::enterInstruction
-#define R Editor::release
-#define P Editor::enterPatternIndice
+#define VOLM song.storeVolume
+#define CHANL song.storeChannelIndex
+#define PATRN song.storePatternIndex
+#define INSTR song.storeInstrumentIndex
+#define I song.enterInstruction
+#define R song.release
+#define P song.enterPatternIndice
 #define K Key
 #define UI32 uint_fast32_t
 
@@ -151,6 +143,14 @@ namespace frere_jacques{
         PATRN(8);
         R(0);
 
-        return new C0deTracker::Track(CLOCK, BASETIME, SPEED, ROWS, FRAMES, CHANNELS, instruments_bank, INSTRUMENTS, patterns, pattern_indices, fx_per_chan);
+        return song;
+    }();
+
+    C0deTracker::Track* init_track(){
+        auto** instruments_bank = new C0deTracker::Instrument*[INSTRUMENTS];
+        instruments_bank[MAIN] = new C0deTracker::Instrument(new C0deTracker::PSG(C0deTracker::TRIANGLE,1.f, 0.5f, C0deTracker::ADSR(4.66f,2.f,0.5f,4.f)), 0.6f);
+        instruments_bank[BASS] = new C0deTracker::Instrument(new C0deTracker::PSG(C0deTracker::SINUS, .5f, 0.f, C0deTracker::ADSR(1000.0f, 2.f, 0.2f, 5.33f)), 1.f);
+
+        return SONG.createTrack(CLOCK, BASETIME, SPEED, instruments_bank, INSTRUMENTS);
     }
 }
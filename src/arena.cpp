@@ -0,0 +1,70 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file arena.cpp
+ * @brief Arena class code
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    Arena::Arena(size_t capacity) {
+        if (capacity > 0) {
+            this->grow(capacity);
+        }
+    }
+
+    Arena::~Arena() {
+        for (Chunk &chunk : this->chunks) {
+            delete[] chunk.data;
+        }
+    }
+
+    void* Arena::allocate(size_t size, size_t alignment) {
+        if (!this->chunks.empty()) {
+            Chunk &last = this->chunks.back();
+            auto address = reinterpret_cast<uintptr_t>(last.data) + this->offset;
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (this->offset + padding + size <= last.size) {
+                this->offset += padding + size;
+                this->used += size;
+                return last.data + this->offset - size;
+            }
+        }
+        //the new chunk is large enough for the block and its worst alignment
+        this->grow(size + alignment > ARENA_CHUNK_SIZE ? size + alignment : ARENA_CHUNK_SIZE);
+        return this->allocate(size, alignment);
+    }
+
+    bool Arena::contains(const void *p) const {
+        auto address = reinterpret_cast<uintptr_t>(p);
+        for (const Chunk &chunk : this->chunks) {
+            auto begin = reinterpret_cast<uintptr_t>(chunk.data);
+            if (begin <= address && address < begin + chunk.size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t Arena::getUsed() const {
+        return this->used;
+    }
+
+    size_t Arena::getCapacity() const {
+        return this->capacity;
+    }
+
+    void Arena::grow(size_t size) {
+        this->chunks.push_back(Chunk{new char[size], size});
+        this->offset = 0;
+        this->capacity += size;
+    }
+}
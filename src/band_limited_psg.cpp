@@ -0,0 +1,205 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include <complex>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file band_limited_psg.cpp
+ * @brief BandLimitedPSG class code, band-limited mip-mapped wavetables of SQUARE, TRIANGLE and SAW
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define BAND_LIMITED_TABLE_SIZE 2048 //samples of a table, a power of 2 for the FFT
+#define BAND_LIMITED_HARMONICS 512 //harmonics of the first table of a chain
+#define BAND_LIMITED_LEVELS 10 //tables of a chain, the last one is a sinus
+#define BAND_LIMITED_DUTY_STEPS 32 //duty cycles k / 32 have their own chain, the others are rounded
+#define BAND_LIMITED_WAVES 3 //SQUARE, TRIANGLE and SAW
+
+namespace C0deTracker {
+
+    namespace {
+        /**
+         * @brief in-place radix 2 inverse FFT, without the 1 / n factor
+         */
+        void inverseFft(std::complex<double> *x, size_t n) {
+            for (size_t i = 1, j = 0; i < n; ++i) {
+                size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(x[i], x[j]);
+                }
+            }
+            for (size_t len = 2; len <= n; len <<= 1) {
+                for (size_t k = 0; k < len / 2; ++k) {
+                    std::complex<double> w = std::polar(1., TWOPI * double(k) / double(len));
+                    for (size_t i = 0; i < n; i += len) {
+                        std::complex<double> u = x[i + k], v = x[i + k + len / 2] * w;
+                        x[i + k] = u + v;
+                        x[i + k + len / 2] = u - v;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Builds the tables of one waveform and duty cycle, BAND_LIMITED_LEVELS tables of
+         * BAND_LIMITED_TABLE_SIZE + 2 samples (the last two repeat the first ones, as Oscillator::readTable needs).
+         * @details The waveforms are piecewise linear, so their Fourier series is exact : the coefficient of harmonic n
+         * is the sum over the breakpoints x of (jump / (2 pi i n) + slope change / (2 pi i n)^2) e^(-2 pi i n x).
+         * The tables have the same shape and offset as the analytic kernels of Oscillator, for an amplitude of 1.
+         */
+        void buildChain(std::vector<float> &chain, uint_fast8_t wavetype, double w) {
+            struct Breakpoint{ double x, jump, slope; };
+            Breakpoint points[3];
+            size_t count;
+            double mean;
+            switch (wavetype) {
+                case SQUARE://0.5 before w, -0.5 after
+                    points[0] = {0., 1., 0.};
+                    points[1] = {w, -1., 0.};
+                    count = 2;
+                    mean = w - 0.5;
+                    break;
+                case TRIANGLE://falls from 0.5 to -0.5 until w / 2, stays at -0.5, rises back from 1 - w / 2
+                    points[0] = {0., 0., -4. / w};
+                    points[1] = {w * 0.5, 0., 2. / w};
+                    points[2] = {1. - w * 0.5, 0., 2. / w};
+                    count = 3;
+                    mean = -0.5 * (1. - w);
+                    break;
+                default://SAW, rises from -0.5 to 0.5 until w, then -0.5
+                    points[0] = {0., 0., 1. / w};
+                    points[1] = {w, -1., -1. / w};
+                    count = 2;
+                    mean = -0.5 * (1. - w);
+                    break;
+            }
+
+            std::vector<std::complex<double>> harmonics(BAND_LIMITED_HARMONICS + 1);
+            for (size_t n = 1; n <= BAND_LIMITED_HARMONICS; ++n) {
+                std::complex<double> d(0., TWOPI * double(n));
+                for (size_t j = 0; j < count; ++j) {
+                    harmonics[n] += (points[j].jump / d + points[j].slope / (d * d)) *
+                                    std::polar(1., -TWOPI * double(n) * points[j].x);
+                }
+            }
+
+            chain.resize(BAND_LIMITED_LEVELS * (BAND_LIMITED_TABLE_SIZE + 2));
+            std::vector<std::complex<double>> x(BAND_LIMITED_TABLE_SIZE);
+            for (size_t level = 0; level < BAND_LIMITED_LEVELS; ++level) {
+                std::fill(x.begin(), x.end(), std::complex<double>(0.));
+                x[0] = mean;
+                for (size_t n = 1; n <= size_t(BAND_LIMITED_HARMONICS >> level); ++n) {
+                    x[n] = harmonics[n];
+                    x[BAND_LIMITED_TABLE_SIZE - n] = std::conj(harmonics[n]);
+                }
+                inverseFft(x.data(), BAND_LIMITED_TABLE_SIZE);
+                float *table = &chain[level * (BAND_LIMITED_TABLE_SIZE + 2)];
+                for (size_t k = 0; k < BAND_LIMITED_TABLE_SIZE; ++k) {
+                    table[k] = float(x[k].real());
+                }
+                table[BAND_LIMITED_TABLE_SIZE] = table[0];
+                table[BAND_LIMITED_TABLE_SIZE + 1] = table[1];
+            }
+        }
+
+        struct Chains {
+            std::once_flag built[BAND_LIMITED_WAVES][BAND_LIMITED_DUTY_STEPS];
+            std::vector<float> tables[BAND_LIMITED_WAVES][BAND_LIMITED_DUTY_STEPS];
+        };
+
+        /**
+         * @return the tables of a waveform for a duty cycle, built by the first voice playing them
+         */
+        const float *chain(uint_fast8_t wavetype, float dc) {
+            static Chains chains;
+            long step = lroundf(dc * BAND_LIMITED_DUTY_STEPS);
+            step = step < 1 ? 1 : (step > BAND_LIMITED_DUTY_STEPS ? BAND_LIMITED_DUTY_STEPS : step);
+            size_t wave = wavetype - SQUARE, bucket = size_t(step) - 1;
+            std::call_once(chains.built[wave][bucket], buildChain, std::ref(chains.tables[wave][bucket]), wavetype,
+                           double(step) / BAND_LIMITED_DUTY_STEPS);
+            return chains.tables[wave][bucket].data();
+        }
+
+        /**
+         * @param step phase step of the voice between two samples (f / sample rate)
+         * @return first table of the chain whose harmonics all stay below half the sample rate
+         */
+        inline size_t level(double step) {
+            double x = step * (2 * BAND_LIMITED_HARMONICS);
+            if (!(x > 1.)) {
+                return 0;
+            }
+            //ceil(log2(x)) read in the bits of the double, the exponent plus one unless x is a power of 2
+            uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            size_t l = size_t((bits >> 52) & 0x7FF) - 1023 + ((bits & 0xFFFFFFFFFFFFFull) != 0);
+            return l < BAND_LIMITED_LEVELS ? l : BAND_LIMITED_LEVELS - 1;
+        }
+    }
+
+    BandLimitedPSG::BandLimitedPSG(uint_fast8_t wavetype) : PSG(wavetype) {}
+    BandLimitedPSG::BandLimitedPSG(uint_fast8_t wavetype, ADSR amp_enveloppe) : PSG(wavetype, amp_enveloppe) {}
+    BandLimitedPSG::BandLimitedPSG(uint_fast8_t wavetype, float dc, ADSR amp_enveloppe) : PSG(wavetype, dc, amp_enveloppe) {}
+    BandLimitedPSG::BandLimitedPSG(uint_fast8_t wavetype, float dc, float p, ADSR amp_enveloppe) : PSG(wavetype, dc, p, amp_enveloppe) {}
+
+    BandLimitedPSG::~BandLimitedPSG() = default;
+
+    bool BandLimitedPSG::isBandLimited() const {
+        return this->getWavetype() == SQUARE || this->getWavetype() == TRIANGLE || this->getWavetype() == SAW;
+    }
+
+    float BandLimitedPSG::oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const {
+        if (!this->isBandLimited()) {
+            return PSG::oscillate(v, a, f, t, rt, dc, p);
+        }
+        float out;
+        this->oscillate(v, &out, 1, &a, &f, &t, &rt, dc, p);
+        return out;
+    }
+
+    void BandLimitedPSG::oscillate(VoiceState &v, float *out, size_t n, const float *a, const float *f,
+                                   const double *t, const double *rt, float dc, float p) const {
+        if (!this->isBandLimited()) {
+            PSG::oscillate(v, out, n, a, f, t, rt, dc, p);
+            return;
+        }
+        const float *tables = chain(this->getWavetype(), dc);
+        float ph[RENDER_BLOCK_SIZE];
+        size_t levels[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            for (size_t k = 0; k < m; ++k) {
+                //a new note starts from time 0, like the phase
+                double dt = (t[done + k] < v.phase_time) ? t[done + k] : t[done + k] - v.phase_time;
+                levels[k] = level(double(f[done + k]) * dt);
+                ph[k] = this->advancePhase(v, f[done + k], t[done + k], dc, p);
+            }
+            //the level only changes when the pitch crosses an octave, each run of samples reads one table
+            for (size_t k = 0, end; k < m; k = end) {
+                for (end = k + 1; end < m && levels[end] == levels[k]; ++end);
+                Oscillator::readTable(out + done + k, end - k, a + done + k, ph + k,
+                                      tables + levels[k] * (BAND_LIMITED_TABLE_SIZE + 2), BAND_LIMITED_TABLE_SIZE,
+                                      true);
+            }
+        }
+        this->applyAmpEnvelope(v, out, n, t, rt);
+    }
+
+    BandLimitedPSG * BandLimitedPSG::clone() const {
+        return new BandLimitedPSG(*this);
+    }
+}
@@ -2,6 +2,12 @@
 // Created by Abdulmajid, Olivier NASSER on 24/08/2020.
 //
 #include "../include/c0de_tracker.hpp"
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define C0DETRACKER_X86_SIMD
+#include <emmintrin.h>
+#endif
 
 /**
  * @file code_tracker.cpp
@@ -14,15 +20,177 @@
 
 namespace  C0deTracker{
 
-    Key::Key(float n, float o) { this->note = n; this->octave = o;}
+    ADSR::ADSR(float A, float D, float S, float R, uint_fast8_t curve) {
+        this->attack = A; this->decay = D; this->sustain = S; this->release = R; this->curve = curve;
+    }
+
+    /**
+     * @brief aim and speed of an exponential segment : level = target + (level - target) * exp(-lambda * dt). The
+     * target is past the end of the segment, so the segment ends in the time a linear one takes.
+     */
+    static void exponentialSegment(const ADSR &env, uint_fast8_t segment, double &target, double &lambda) {
+        double attack_log = log((1. + ENVELOPE_ATTACK_RATIO) / ENVELOPE_ATTACK_RATIO);
+        double decay_log = log((1. + ENVELOPE_DECAY_RATIO) / ENVELOPE_DECAY_RATIO);
+        double span = MASTER_VOLUME - env.sustain;
+        switch (segment) {
+            case ADSR::ATTACK:
+                target = MASTER_VOLUME * (1. + ENVELOPE_ATTACK_RATIO);
+                lambda = env.attack * attack_log;
+                break;
+            case ADSR::DECAY://a decay ending above the attack level never runs, the sustain is reached at once
+                target = env.sustain - ENVELOPE_DECAY_RATIO * span;
+                lambda = (span > 0.) ? env.decay * decay_log / span : 0.;
+                break;
+            default://release, from full scale in 1 / release seconds like the linear one
+                target = -ENVELOPE_DECAY_RATIO * MASTER_VOLUME;
+                lambda = env.release * decay_log;
+                break;
+        }
+    }
 
-    Key::Key(){this->note = Notes::CONTINUE; this->octave = Notes::CONTINUE;}
+    size_t ADSR::render(VoiceState &v, float *out, size_t n, const double *t, const double *rt) const {
+        //the envelope of the voice stays in registers during the block
+        double level = v.envelope, note_time = v.envelope_time, release_time = v.release_time;
+        uint_fast8_t segment = v.segment;
+        bool exponential = this->curve == EXPONENTIAL;
+        //multiplier of the exponential segment, computed again only when the segment or the time step changes
+        double target = 0., lambda = 0., mul = 1., mul_dt = -1.;
+        uint_fast8_t mul_segment = IDLE;
+        size_t audible = 0;
+        for (size_t k = 0; k < n; ++k) {
+            if (t[k] < note_time || (t[k] == 0. && segment == IDLE)) {//new note
+                segment = ATTACK;
+                level = 0.;
+                note_time = 0.;
+            }
+            double dt = t[k] - note_time;
+            note_time = t[k];
+            if (v.release && rt[k] >= 0.) {//the release runs on its own clock, it started rt seconds ago
+                if (segment < RELEASE) {
+                    segment = RELEASE;
+                    release_time = 0.;
+                }
+                dt = rt[k] - release_time;
+                release_time = rt[k];
+            }
 
-    ADSR::ADSR(float A, float D, float S, float R) { this->attack = A; this->decay = D; this->sustain = S; this->release = R;}
+            if (dt > 0. && segment != SUSTAIN && segment != IDLE) {
+                if (exponential) {
+                    if (segment != mul_segment || fabs(dt - mul_dt) > mul_dt * 1e-6) {
+                        exponentialSegment(*this, segment, target, lambda);
+                        mul = exp(-lambda * dt);
+                        mul_dt = dt;
+                        mul_segment = segment;
+                    }
+                    level = target + (level - target) * mul;
+                } else if (segment == ATTACK) {
+                    level += this->attack * dt;
+                } else {
+                    level -= ((segment == DECAY) ? this->decay : this->release) * dt;
+                }
+                if (segment == ATTACK && level >= MASTER_VOLUME) {
+                    //the end of the step past the peak is spent decaying
+                    double extra = exponential ? 0. : (level - MASTER_VOLUME) / this->attack;
+                    level = MASTER_VOLUME - this->decay * extra;
+                    segment = DECAY;
+                }
+            }
+            if (segment == DECAY && level <= this->sustain) {
+                level = this->sustain;
+                segment = (this->sustain > 0.f) ? SUSTAIN : IDLE;
+            }
+            if (segment == RELEASE && level <= 0.) {
+                level = 0.;
+                segment = IDLE;
+            }
+            if (segment == IDLE) {
+                level = 0.;
+            } else {
+                audible = k + 1;
+            }
+            out[k] = float(level);
+        }
+        v.envelope = level;
+        v.envelope_time = note_time;
+        v.release_time = release_time;
+        v.segment = uint8_t(segment);
+        return audible;
+    }
+
+    bool VoiceState::staysIdle(const double *t, size_t n) const {
+        if (this->segment != ADSR::IDLE) {
+            return false;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (t[k] < this->envelope_time || t[k] == 0.) {//same test as ADSR::render for a new note
+                return false;
+            }
+        }
+        return true;
+    }
 
 
     namespace Notes {
-        float pitch2freq(float p){return pow(1.059460646483f, p) * 440.0f;}
+        /*
+         * 2^x = 2^i * 2^r with i the nearest integer of x and r in [-0.5, 0.5]. 2^r is a 6th order Taylor polynomial
+         * (error below 1.3e-7 on that range) and 2^i is written straight into the float exponent.
+         * The rounding adds and subtracts 1.5 * 2^23, which rounds to the nearest integer in SSE2 as in scalar code, so
+         * both give the same frequencies.
+         */
+#define EXP2_ROUND 12582912.f
+#define EXP2_C6 1.5403530e-4f
+#define EXP2_C5 1.3333558e-3f
+#define EXP2_C4 9.6181291e-3f
+#define EXP2_C3 5.5504109e-2f
+#define EXP2_C2 0.24022651f
+#define EXP2_C1 0.69314718f
+
+        float fastExp2(float x) {
+            x = (x < -126.f) ? -126.f : ((x > 127.f) ? 127.f : x);
+            float i = (x + EXP2_ROUND) - EXP2_ROUND;
+            float r = x - i;
+            float y = EXP2_C6;
+            y = y * r + EXP2_C5;
+            y = y * r + EXP2_C4;
+            y = y * r + EXP2_C3;
+            y = y * r + EXP2_C2;
+            y = y * r + EXP2_C1;
+            y = y * r + 1.f;
+            int32_t bits = (int32_t(i) + 127) << 23;
+            float scale;
+            memcpy(&scale, &bits, sizeof(scale));
+            return y * scale;
+        }
+
+        float pitch2freq(float p){return fastExp2(p * float(SEMITONE_LOG2)) * 440.0f;}
+
+        void pitch2freq(float *f, const float *p, size_t n) {
+            size_t k = 0;
+#ifdef C0DETRACKER_X86_SIMD
+            const __m128 lo = _mm_set1_ps(-126.f), hi = _mm_set1_ps(127.f), round = _mm_set1_ps(EXP2_ROUND);
+            const __m128 semitone = _mm_set1_ps(float(SEMITONE_LOG2)), a4 = _mm_set1_ps(440.0f), one = _mm_set1_ps(1.f);
+            const __m128 c6 = _mm_set1_ps(EXP2_C6), c5 = _mm_set1_ps(EXP2_C5), c4 = _mm_set1_ps(EXP2_C4);
+            const __m128 c3 = _mm_set1_ps(EXP2_C3), c2 = _mm_set1_ps(EXP2_C2), c1 = _mm_set1_ps(EXP2_C1);
+            for (; k + 4 <= n; k += 4) {
+                __m128 x = _mm_mul_ps(_mm_loadu_ps(p + k), semitone);
+                x = _mm_min_ps(_mm_max_ps(x, lo), hi);
+                __m128 i = _mm_sub_ps(_mm_add_ps(x, round), round);
+                __m128 r = _mm_sub_ps(x, i);
+                __m128 y = c6;
+                y = _mm_add_ps(_mm_mul_ps(y, r), c5);
+                y = _mm_add_ps(_mm_mul_ps(y, r), c4);
+                y = _mm_add_ps(_mm_mul_ps(y, r), c3);
+                y = _mm_add_ps(_mm_mul_ps(y, r), c2);
+                y = _mm_add_ps(_mm_mul_ps(y, r), c1);
+                y = _mm_add_ps(_mm_mul_ps(y, r), one);
+                __m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(i), _mm_set1_epi32(127)), 23);
+                _mm_storeu_ps(f + k, _mm_mul_ps(_mm_mul_ps(y, _mm_castsi128_ps(bits)), a4));
+            }
+#endif
+            for (; k < n; ++k) {
+                f[k] = pitch2freq(p[k]);
+            }
+        }
 
         float key2pitch(Key k){
             return key2pitch(k.note, k.octave);
@@ -45,48 +213,37 @@ namespace  C0deTracker{
         }
     }
 
-    Instruction::Instruction(uint_fast8_t instrument, Key k, float vol) : key(k) {
-        this->instrument_index = instrument; this->volume = vol; this->effects = nullptr;
+    double slideTime(double t, double since, uint_fast32_t samples, double dt) {
+        //sum of (t_i - since) for the samples t_i = t, t - dt, ..., t - (samples - 1) * dt
+        return double(samples) * (t - since) - dt * 0.5 * double(samples) * double(samples - 1);
     }
 
-    Instruction::Instruction(uint_fast8_t instrument, float note, float octave, float vol) : key(Key(note, octave)) {
-        this->instrument_index = instrument; this->volume = vol; this->effects = nullptr;
+    Instruction::Instruction(uint_fast8_t instrument, Key k, float vol, const std::vector<uint_fast32_t> &effects) : key(k){
+        this->instrument_index = instrument; this->volume = vol;
+        for(uint_fast8_t i = 0; i < effects.size() && i < EFFECT_COLUMNS; ++i){
+            this->setEffect(i, effects[i]);
+        }
     }
 
-    Instruction::Instruction(uint_fast8_t instrument, Key k, float vol, uint_fast32_t**effects) : key(k){
-        this->instrument_index = instrument; this->volume = vol; this->effects = effects;
-    }
+    Instruction::Instruction(uint_fast8_t instrument, float note, float octave, float vol,
+                             const std::vector<uint_fast32_t> &effects) : Instruction(instrument, Key(note, octave), vol, effects) {}
 
-    Instruction::Instruction(uint_fast8_t instrument, float note, float octave, float vol, uint_fast32_t**effects) : key(note, octave) {
-        this->instrument_index = instrument; this->volume = vol; this->effects = effects;
+    Pattern::Pattern(uint_fast8_t rows, uint_fast8_t number_of_fx) {
+        this->instructions = new Instruction[rows];
+        this->rows = rows;
+        this->n_fx = number_of_fx < EFFECT_COLUMNS ? number_of_fx : EFFECT_COLUMNS;
     }
 
-    Instruction::Instruction() {this->volume = Notes::CONTINUE; this->instrument_index = Notes::CONTINUE; this->key = Key(); this->effects = nullptr;}
-
-    Instruction::~Instruction() {delete[] this->effects;}
-
-    Pattern::Pattern(uint_fast8_t rows, uint_fast8_t number_of_fx) {
-        this->instructions = new Instruction* [rows];
-        for(uint_fast8_t i = 0; i < rows; ++i){
-            this->instructions[i] = new Instruction();
-        }
+    Pattern::Pattern(uint_fast8_t rows, uint_fast8_t number_of_fx, Instruction *instructions) {
+        this->instructions = instructions;
         this->rows = rows;
-        this->n_fx = number_of_fx;
+        this->n_fx = number_of_fx < EFFECT_COLUMNS ? number_of_fx : EFFECT_COLUMNS;
+        this->owns_instructions = false;
     }
 
     Pattern::~Pattern() {
-        for(uint_fast8_t i = 0; i < this->rows; ++i){
-            for(uint_fast8_t j = 0; j < this->n_fx; ++j){
-                if(this->instructions[i]->effects != nullptr){
-                    if(this->instructions[i]->effects[j] == nullptr){
-                        break;
-                    }else{
-                        delete this->instructions[i]->effects[j];
-                    }
-                }
-            }
-            delete this->instructions[i];
+        if(this->owns_instructions){
+            delete[] this->instructions;
         }
-        delete[] this->instructions;
     }
 }
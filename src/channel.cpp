@@ -42,8 +42,23 @@ namespace C0deTracker {
         this->number = Channel::chancount++;
     }
 
-    Channel::~Channel() {
-        delete this->instrument;
+    Channel::~Channel() = default;
+
+    void Channel::restore(const Channel &other) {
+        if (this == &other) {
+            return;
+        }
+        //the number and the mute switch belong to the user, not to the playback state
+        uint_fast8_t number = this->number;
+        bool enable_sound = this->enable_sound;
+        *this = other;//the instrument is shared, the voice is copied with the channel
+        this->number = number;
+        this->enable_sound = enable_sound;
+    }
+
+    void Channel::selectInstrument(const InstrumentDef *def) {
+        this->instrument = def;
+        this->voice = VoiceState();
     }
 
     double Channel::getTimeRelease() const {
@@ -67,10 +82,7 @@ namespace C0deTracker {
     }
 
     void Channel::setInstructionState(Instruction *instruc) {
-        this->instruct_state.volume = instruc->volume;
-        this->instruct_state.instrument_index = instruc->instrument_index;
-        this->instruct_state.key = instruc->key;
-        this->instruct_state.effects = instruc->effects;
+        this->instruct_state = *instruc;//a row is 32 bytes, copied at once
     }
 
     void Channel::setVolumeInstructionState(float a) {
@@ -78,29 +90,43 @@ namespace C0deTracker {
     }
 
     void Channel::update_fx(double t) {
-        this->volume -= (this->volume_slide_down / this->track->getSpeed()) * (t - this->volume_slide_time);
-        if (this->volume <= 0) {
-            this->volume = 0.f;
-            this->volume_slide_down = 0.f;
-        }
-        this->volume += (this->volume_slide_up / this->track->getSpeed()) * (t - this->volume_slide_time);
-        if (this->volume >= MASTER_VOLUME) {
-            this->volume = MASTER_VOLUME;
-            this->volume_slide_up = 0.f;
-        }
+        this->modulate(t, 1, 0.);
+        this->tick(t);
+    }
 
-        this->pitch_slide_val -= (this->pitch_slide_down / this->track->getSpeed()) * (t - this->pitch_slide_time);
-        this->pitch_slide_val += (this->pitch_slide_up   / this->track->getSpeed()) * (t - this->pitch_slide_time);
+    void Channel::modulate(double t, uint_fast32_t samples, double dt) {
+        if (this->volume_slide_down != 0.f || this->volume_slide_up != 0.f) {
+            double elapsed = slideTime(t, this->volume_slide_time, samples, dt);
+            this->volume -= (this->volume_slide_down / this->track->getSpeed()) * elapsed;
+            if (this->volume <= 0) {
+                this->volume = 0.f;
+                this->volume_slide_down = 0.f;
+            }
+            this->volume += (this->volume_slide_up / this->track->getSpeed()) * elapsed;
+            if (this->volume >= MASTER_VOLUME) {
+                this->volume = MASTER_VOLUME;
+                this->volume_slide_up = 0.f;
+            }
+        }
 
-        this->panning += (this->panning_slide_right / this->track->getSpeed()) * (t - this->panning_slide_time);
-        if (this->panning >= MASTER_VOLUME) {
-            this->panning = MASTER_VOLUME;
-            this->panning_slide_right = 0.f;
+        if (this->pitch_slide_down != 0.f || this->pitch_slide_up != 0.f) {
+            double elapsed = slideTime(t, this->pitch_slide_time, samples, dt);
+            this->pitch_slide_val -= (this->pitch_slide_down / this->track->getSpeed()) * elapsed;
+            this->pitch_slide_val += (this->pitch_slide_up   / this->track->getSpeed()) * elapsed;
         }
-        this->panning -= (this->panning_slide_left / this->track->getSpeed()) * (t - this->panning_slide_time);
-        if (this->panning <= 0) {
-            this->panning = 0;
-            this->panning_slide_left = 0.f;
+
+        if (this->panning_slide_right != 0.f || this->panning_slide_left != 0.f) {
+            double elapsed = slideTime(t, this->panning_slide_time, samples, dt);
+            this->panning += (this->panning_slide_right / this->track->getSpeed()) * elapsed;
+            if (this->panning >= MASTER_VOLUME) {
+                this->panning = MASTER_VOLUME;
+                this->panning_slide_right = 0.f;
+            }
+            this->panning -= (this->panning_slide_left / this->track->getSpeed()) * elapsed;
+            if (this->panning <= 0) {
+                this->panning = 0;
+                this->panning_slide_left = 0.f;
+            }
         }
 
         if (this->tremolo_speed == 0.f || this->tremolo_depth == 0.f) {
@@ -115,6 +141,45 @@ namespace C0deTracker {
         } else {
             this->vibrato_val = this->vibrato_depth * sin(TWOPI * this->vibrato_speed * (t - this->vibrato_time));
         }
+    }
+
+    bool Channel::isDelaying() const {
+        return this->delay_counter <= this->delay && this->delay > 0 && this->n_time_to_delrel > 0;
+    }
+
+    bool Channel::hasTickEffects() const {
+        return this->arpeggio || (this->transpose_semitones > 0 && this->n_time_to_transpose > 0) ||
+               (this->retrieg_number > 0 && this->n_time_to_retrieg > 0) || this->isDelaying() ||
+               (this->release > 0 && !this->isReleased() && this->n_time_to_delrel > 0) ||
+               (this->portamento && this->porta_pitch_dif != 0);
+    }
+
+    bool Channel::tickDue(double t) const {
+        double tick = 1. / this->track->getClock();
+        if (this->arpeggio && t - this->arpeggio_step >= tick) {
+            return true;
+        }
+        if (this->transpose_semitones > 0 && this->n_time_to_transpose > 0 &&
+            this->transpose_semitone_counter < this->transpose_semitones) {
+            double delay = (this->transpose_delay > 0x7F) ? double(this->transpose_delay - 0x7F) : double(this->transpose_delay);
+            if (t - this->transpose_time_step >= delay / this->track->getClock()) {
+                return true;
+            }
+        }
+        if (this->retrieg_number > 0 && this->n_time_to_retrieg > 0 && this->retrieg_counter < this->retrieg_number &&
+            t - this->retrieg_time_step >= double(this->retrieg_delay) / this->track->getClock()) {
+            return true;
+        }
+        if (this->isDelaying() ||
+            (this->release > 0 && !this->isReleased() && this->release_counter <= this->release && this->n_time_to_delrel > 0)) {
+            if (t - this->delrel_time_step >= tick) {
+                return true;
+            }
+        }
+        return this->portamento && this->porta_pitch_dif != 0 && t - this->portamento_time_step >= tick;
+    }
+
+    void Channel::tick(double t) {
         if(this->arpeggio){
             if (t - this->arpeggio_step >= 1./this->track->getClock()){
                 this->arpeggio_step += 1./this->track->getClock();
@@ -195,103 +260,94 @@ namespace C0deTracker {
         }
     }
 
-    bool Channel::decode_fx(uint_fast32_t fx, double t) {
-        uint_fast8_t fx_code = fx >> 4 * 6;
-        uint_fast32_t fx_val = fx & 0x00FFFFFF;
-        //printf("%.3f FX CODE : %x ; FX VAL : %x\n", t, fx_code, fx_val);
-        switch (fx_code) {
-            case 0x10://pitch slide up
-                this->pitch_slide_up = float(fx_val) / float(0x00FFFFFF);
+    void Channel::applyEffect(const EffectCommand &fx, double t) {
+        switch (fx.type) {
+            case EffectCommand::PITCH_SLIDE_UP:
+                this->pitch_slide_up = fx.x;
                 this->pitch_slide_down = 0.f;
                 this->pitch_slide_time = t;
-                return true;
-            case 0x11://pitch slide down
-                this->pitch_slide_down = float(fx_val) / float(0x00FFFFFF);
+                break;
+            case EffectCommand::PITCH_SLIDE_DOWN:
+                this->pitch_slide_down = fx.x;
                 this->pitch_slide_up = 0.f;
                 this->pitch_slide_time = t;
-                return true;
-            case 0x12://vibrato
-                this->vibrato_speed = float((fx_val >> 4 * 3)) / float(0x100);
-                this->vibrato_depth = float(fx_val & 0xFFF) / float(0x800);
+                break;
+            case EffectCommand::VIBRATO:
+                this->vibrato_speed = fx.x;
+                this->vibrato_depth = fx.y;
                 this->vibrato_time = t;
-                return true;
-            case 0x13://set pitch
-                this->pitch = (float(fx_val) - float(0x800000)) / float(0x800000);
-                return true;
-            case 0x14://set volume
-                this->volume = float(fx_val) / float(0x00FFFFFF);
-                return true;
-            case 0x15://volume slide up
-                this->volume_slide_up = float(fx_val) / float(0x00FFFFFF);
+                break;
+            case EffectCommand::PITCH:
+                this->pitch = fx.x;
+                break;
+            case EffectCommand::VOLUME:
+                this->volume = fx.x;
+                break;
+            case EffectCommand::VOLUME_SLIDE_UP:
+                this->volume_slide_up = fx.x;
                 this->volume_slide_down = 0.f;
                 this->volume_slide_time = t;
-                return true;
-            case 0x16://volume slide down
-                this->volume_slide_down = float(fx_val) / float(0x00FFFFFF);
+                break;
+            case EffectCommand::VOLUME_SLIDE_DOWN:
+                this->volume_slide_down = fx.x;
                 this->volume_slide_up = 0.f;
                 this->volume_slide_time = t;
-                return true;
-            case 0x17://tremolo
-                this->tremolo_speed = float(fx_val >> 4 * 3) / float(0x100);
-                this->tremolo_depth = float(fx_val & 0xFFF) / float(0xFFF);
+                break;
+            case EffectCommand::TREMOLO:
+                this->tremolo_speed = fx.x;
+                this->tremolo_depth = fx.y;
                 this->tremolo_time = t;
-                return true;
-            case 0x18://set  panning
-                this->panning = float(fx_val) / float(0xFFFFFF);
-                return true;
-            case 0x19://arpeggio
-                this->arpeggio = true;
+                break;
+            case EffectCommand::PANNING:
+                this->panning = fx.x;
+                break;
+            case EffectCommand::ARPEGGIO:
+                this->arpeggio = false;
                 this->arpeggio_step = t;
-                this->arpeggio_val[0] = float(fx_val >> 4 * 5); printf("arpeggio\n0 : %x\n", this->arpeggio_val[0]);
-                this->arpeggio_val[1] = float( (fx_val >> 4 * 4) & 0xF); printf("1 : %x\n", this->arpeggio_val[1]);
-                this->arpeggio_val[2] = float( (fx_val >> 4 * 3) & 0xF); printf("2 : %x\n", this->arpeggio_val[2]);
-                this->arpeggio_val[3] = float( (fx_val >> 4 * 2) & 0xF); printf("3 : %x\n", this->arpeggio_val[3]);
-                this->arpeggio_val[4] = float( (fx_val >> 4 * 1) & 0xF); printf("4 : %x\n", this->arpeggio_val[4]);
-                this->arpeggio_val[5] = float(fx_val & 0xF); printf("5 : %x\n", this->arpeggio_val[5]);
-                if(this->arpeggio_val[0] == 0 && this->arpeggio_val[1] == 0 && this->arpeggio_val[2] == 0 && this->arpeggio_val[3] == 0 && this->arpeggio_val[4] == 0 && this->arpeggio_val[5] == 0){
-                    this->arpeggio = false;
+                for (uint_fast8_t i = 0; i < 6; ++i) {
+                    this->arpeggio_val[i] = fx.args[i];
+                    this->arpeggio = this->arpeggio || fx.args[i] != 0;
                 }
-                return true;
-            case 0x1A://transpose
-                this->transpose_delay = (fx_val >> 4 * 4);
-                this->transpose_semitones = (fx_val & 0xFF00) >> 4 * 2;
-                this->n_time_to_transpose = (fx_val & 0xFF);
+                break;
+            case EffectCommand::TRANSPOSE:
+                this->transpose_delay = fx.args[0];
+                this->transpose_semitones = fx.args[1];
+                this->n_time_to_transpose = fx.args[2];
                 this->transpose_time_step = t;
-                return true;
-            case 0x1B://portamento
-                this->portamento = fx_val != 0;
-                this->portamento_speed = float(fx_val)/float(0x800000);
+                break;
+            case EffectCommand::PORTAMENTO:
+                this->portamento = fx.x != 0.f;
+                this->portamento_speed = fx.x;
                 this->portamento_time_step = t;
                 if(this->portamento_speed == 0){
                     this->porta_pitch_dif = 0;
                 }
-                return true;
-            case 0x1C://retrieg
-                this->retrieg_delay = (fx_val >> 4 * 4);
-                this->retrieg_number = (fx_val & 0xFF00) >> 4 * 2;
-                this->n_time_to_retrieg = (fx_val & 0xFF);
+                break;
+            case EffectCommand::RETRIEG:
+                this->retrieg_delay = fx.args[0];
+                this->retrieg_number = fx.args[1];
+                this->n_time_to_retrieg = fx.args[2];
                 this->retrieg_time_step = t;
-                return true;
-            case 0x1D://slide right panning
-                this->panning_slide_right = float(fx_val) / float(0xFFFFFF);
+                break;
+            case EffectCommand::PANNING_SLIDE_RIGHT:
+                this->panning_slide_right = fx.x;
                 this->panning_slide_left = 0.0f;
                 this->panning_slide_time = t;
-                return true;
-            case 0x1E://slide left panning
-                this->panning_slide_left = float(fx_val) / float(0xFFFFFF);
+                break;
+            case EffectCommand::PANNING_SLIDE_LEFT:
+                this->panning_slide_left = fx.x;
                 this->panning_slide_right = 0.0f;
                 this->panning_slide_time = t;
-                return true;
-            case 0x1F:
-                this->delay = (fx_val >> 4 * 4);
-                this->release = (fx_val & 0xFF00) >> 4 * 2;
-                this->n_time_to_delrel = (fx_val & 0xFF);
+                break;
+            case EffectCommand::DELAY_RELEASE:
+                this->delay = fx.args[0];
+                this->release = fx.args[1];
+                this->n_time_to_delrel = fx.args[2];
                 this->delrel_time_step = t;
-                return true;
+                break;
             default:
-                return false;
+                break;
         }
     }
 
-
 }
\ No newline at end of file
@@ -27,17 +27,44 @@ namespace C0deTracker {
     const uint_fast8_t *Editor::fx_per_chan = nullptr;
     Pattern **Editor::pattern = nullptr;
     uint_fast8_t  ** Editor::pattern_indices = nullptr;
+    Arena *Editor::arena = nullptr;
+    Pattern *Editor::empty = nullptr;
 
     void Editor::loadTrackProperties(uint_fast8_t number_of_rows, uint_fast8_t number_of_frames,
                                      uint_fast8_t number_of_channels, const uint_fast8_t *effects_per_chan) {
         Editor::rows = number_of_rows; Editor::frames = number_of_frames;
         Editor::channels = number_of_channels; Editor::fx_per_chan = effects_per_chan;
+        Editor::arena = nullptr;//a song never given to a track keeps its arena, like it kept its patterns
+        Editor::empty = nullptr;
+    }
+
+    Arena *Editor::songArena() {
+        if(Editor::arena == nullptr){
+            size_t n = Editor::channels * Editor::frames;
+            size_t pattern = sizeof(Pattern) + alignof(Pattern) + Editor::rows * sizeof(Instruction) + alignof(Instruction);
+            size_t index = sizeof(uint_fast8_t*) + sizeof(uint_fast8_t);
+            //the tables and the empty pattern, the arena grows with the patterns written
+            Editor::arena = new Arena(n * (sizeof(Pattern*) + index) + pattern + ARENA_CHUNK_SIZE);
+        }
+        return Editor::arena;
     }
 
     Pattern** Editor::loadEmptyPatterns() {
-        auto **p = new C0deTracker::Pattern*[Editor::channels * Editor::frames];
+        Arena *a = Editor::songArena();
+        Editor::empty = a->create<Pattern>(Editor::rows, 0, a->createArray<Instruction>(Editor::rows));
+        auto **p = a->createArray<Pattern*>(Editor::channels * Editor::frames);
         for(uint_fast16_t i = 0; i < Editor::channels * Editor::frames; ++i){
-            p[i] = new C0deTracker::Pattern(Editor::rows, Editor::fx_per_chan[i / Editor::frames]);
+            p[i] = Editor::empty;
+        }
+        return p;
+    }
+
+    Pattern *Editor::current() {
+        Pattern *&p = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index];
+        if(p == Editor::empty){
+            Arena *a = Editor::songArena();
+            p = a->create<Pattern>(Editor::rows, Editor::fx_per_chan[Editor::chan_index],
+                                   a->createArray<Instruction>(Editor::rows));
         }
         return p;
     }
@@ -102,10 +129,10 @@ namespace C0deTracker {
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index,
                                   C0deTracker::Key key, float volume) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = instrument_index;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->key = key;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = instrument_index;
+            Editor::current()->instructions[instruction_index].volume = volume;
+            Editor::current()->instructions[instruction_index].key = key;
         }
     }
 
@@ -155,170 +182,143 @@ namespace C0deTracker {
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index,
                                   C0deTracker::Key key, float volume, uint_fast32_t **effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = instrument_index;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->key = key;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects = effects;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = instrument_index;
+            Editor::current()->instructions[instruction_index].volume = volume;
+            Editor::current()->instructions[instruction_index].key = key;
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, C0deTracker::Key key,
                                   float volume, std::vector<uint_fast32_t> effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = instrument_index;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->key = key;
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                    new uint_fast32_t*[size];
-            if(effects.size() < size){
-                size =  effects.size();
-            }
-            for(int i = 0; i < size; ++i){
-                Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects[i] = new uint_fast32_t(effects[i]);
-            }
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = instrument_index;
+            Editor::current()->instructions[instruction_index].volume = volume;
+            Editor::current()->instructions[instruction_index].key = key;
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast8_t instrument_index, C0deTracker::Key key,
                                   float volume, uint_fast32_t effect) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = instrument_index;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->key = key;
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                        new uint_fast32_t*[size]{new uint_fast32_t(effect)};
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = instrument_index;
+            Editor::current()->instructions[instruction_index].volume = volume;
+            Editor::current()->instructions[instruction_index].key = key;
+            Editor::storeEffects(instruction_index, effect);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, float volume) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows) {
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows) {
+            Editor::current()->instructions[instruction_index].volume = volume;
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast32_t **effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects = effects;
+        if(instruction_index < Editor::current()->rows){
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, float volume, uint_fast32_t **effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects = effects;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].volume = volume;
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, std::vector<uint_fast32_t> effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                    new uint_fast32_t*[size];
-            if(effects.size() < size){
-                size =  effects.size();
-            }
-            for(int i = 0; i < size; ++i){
-                Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects[i] = new uint_fast32_t(effects[i]);
-            }
+        if(instruction_index < Editor::current()->rows){
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, float volume, std::vector<uint_fast32_t> effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].volume = volume;
             Editor::enterInstruction(instruction_index, std::move(effects));
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, uint_fast32_t effect) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                    new uint_fast32_t*[size]{new uint_fast32_t(effect)};
+        if(instruction_index < Editor::current()->rows){
+            Editor::storeEffects(instruction_index, effect);
         }
     }
 
     void Editor::enterInstruction(uint_fast8_t instruction_index, float volume, uint_fast32_t effect) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].volume = volume;
             Editor::enterInstruction(instruction_index, effect);
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, float volume) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
+            Editor::current()->instructions[instruction_index].volume = volume;
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, uint_fast32_t **effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects = effects;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, float volume, uint_fast32_t **effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects = effects;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
+            Editor::storeEffects(instruction_index, effects);
+            Editor::current()->instructions[instruction_index].volume = volume;
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, std::vector<uint_fast32_t> effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                    new uint_fast32_t*[size];
-            if(effects.size() < size){
-                size =  effects.size();
-            }
-            for(int i = 0; i < size; ++i){
-                Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects[i] = new uint_fast32_t(effects[i]);
-            }
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
+            Editor::storeEffects(instruction_index, effects);
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, float volume, std::vector<uint_fast32_t> effects) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].volume = volume;
             Editor::release(instruction_index, std::move(effects));
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, uint_fast32_t effect) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows){
-            uint_fast8_t size = Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->n_fx;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->instrument_index = C0deTracker::Notes::RELEASE;
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->effects =
-                        new uint_fast32_t*[size]{new uint_fast32_t(effect)};
+        if(instruction_index < Editor::current()->rows){
+            Editor::current()->instructions[instruction_index].instrument_index = C0deTracker::Notes::RELEASE;
+            Editor::storeEffects(instruction_index, effect);
         }
     }
 
     void Editor::release(uint_fast8_t instruction_index, float volume, uint_fast32_t effect) {
-        if(instruction_index < Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->rows) {
-            Editor::pattern[Editor::chan_index * Editor::frames + Editor::pattern_index]->instructions[instruction_index]->volume = volume;
+        if(instruction_index < Editor::current()->rows) {
+            Editor::current()->instructions[instruction_index].volume = volume;
             Editor::release(instruction_index, effect);
         }
     }
 
     uint_fast8_t** Editor::loadEmptyPatternsIndices() {
-        auto** pi = new uint8_t*[Editor::channels * Editor::frames];
+        Arena *a = Editor::songArena();
+        auto** pi = a->createArray<uint_fast8_t*>(Editor::channels * Editor::frames);
+        auto* cells = a->createArray<uint_fast8_t>(Editor::channels * Editor::frames);
         for(uint_fast8_t i = 0; i < Editor::channels; ++i){
             for(uint_fast8_t j = 0; j < Editor::frames; ++j){
-                pi[i * Editor::frames + j] = new uint_fast8_t(j);
+                cells[i * Editor::frames + j] = j;
+                pi[i * Editor::frames + j] = &cells[i * Editor::frames + j];
             }
         }
         return pi;
@@ -328,6 +328,41 @@ namespace C0deTracker {
         *Editor::pattern_indices[channel * Editor::frames + frame] = pattern_indice;
     }
 
+    void Editor::storeEffects(uint_fast8_t instruction_index, uint_fast32_t **effects) {
+        Pattern *p = Editor::current();
+        p->instructions[instruction_index].clearEffects();
+        if(effects == nullptr){
+            return;
+        }
+        //the effects are copied in the row, the cells given to the editor are freed like the pattern used to do, the
+        //ones past the EFFECT_COLUMNS kept by the pattern too
+        for(uint_fast8_t i = 0; i < Editor::fx_per_chan[Editor::chan_index]; ++i){
+            if(effects[i] != nullptr){
+                if(i < p->n_fx){
+                    p->instructions[instruction_index].setEffect(i, *effects[i]);
+                }
+                delete effects[i];
+            }
+        }
+        delete[] effects;
+    }
+
+    void Editor::storeEffects(uint_fast8_t instruction_index, const std::vector<uint_fast32_t> &effects) {
+        Pattern *p = Editor::current();
+        p->instructions[instruction_index].clearEffects();
+        for(uint_fast8_t i = 0; i < p->n_fx && i < effects.size(); ++i){
+            p->instructions[instruction_index].setEffect(i, effects[i]);
+        }
+    }
+
+    void Editor::storeEffects(uint_fast8_t instruction_index, uint_fast32_t effect) {
+        Pattern *p = Editor::current();
+        p->instructions[instruction_index].clearEffects();
+        if(p->n_fx > 0){
+            p->instructions[instruction_index].setEffect(0, effect);
+        }
+    }
+
 
 
 
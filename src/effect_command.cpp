@@ -0,0 +1,71 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file effect_command.cpp
+ * @brief EffectCommand structure code, decoding of the effect codes
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    bool EffectCommand::decode(uint_fast32_t fx, EffectCommand &command) {
+        uint_fast8_t fx_code = fx >> 4 * 6;
+        uint_fast32_t fx_val = fx & 0x00FFFFFF;
+        command = EffectCommand();
+        command.type = uint8_t(fx_code);
+        switch (fx_code) {
+            case TRACK_PITCH_SLIDE_UP: case TRACK_PITCH_SLIDE_DOWN: case TRACK_VOLUME: case TRACK_VOLUME_SLIDE_UP:
+            case TRACK_VOLUME_SLIDE_DOWN: case TRACK_PANNING: case TRACK_PANNING_SLIDE_RIGHT:
+            case TRACK_PANNING_SLIDE_LEFT: case PITCH_SLIDE_UP: case PITCH_SLIDE_DOWN: case VOLUME:
+            case VOLUME_SLIDE_UP: case VOLUME_SLIDE_DOWN: case PANNING: case PANNING_SLIDE_RIGHT:
+            case PANNING_SLIDE_LEFT://xx xx xx / FF FF FF
+                command.x = float(fx_val) / float(0x00FFFFFF);
+                return true;
+            case TRACK_VIBRATO: case VIBRATO://xxx speed / 100, yyy depth / 800
+                command.x = float(fx_val >> 4 * 3) / float(0x100);
+                command.y = float(fx_val & 0xFFF) / float(0x800);
+                return true;
+            case TRACK_TREMOLO: case TREMOLO://xxx speed / 100, yyy depth / FFF
+                command.x = float(fx_val >> 4 * 3) / float(0x100);
+                command.y = float(fx_val & 0xFFF) / float(0xFFF);
+                return true;
+            case TRACK_PITCH: case PITCH://80 00 00 is no change
+                command.x = (float(fx_val) - float(0x800000)) / float(0x800000);
+                return true;
+            case TRACK_SPEED://xxx + yyy / FFF
+                command.x = float(fx_val >> 4 * 3) + float(fx_val & 0xFFF) / float(0xFFF);
+                return true;
+            case JUMP://frame xxx, row yyy, a song has at most 255 frames and rows
+                if ((fx_val >> 4 * 3) > 0xFF || (fx_val & 0xFFF) > 0xFF) {
+                    return false;
+                }
+                command.args[0] = uint8_t(fx_val >> 4 * 3);
+                command.args[1] = uint8_t(fx_val & 0xFFF);
+                return true;
+            case STOP:
+                return true;
+            case ARPEGGIO://one semitone offset per digit
+                for (uint_fast8_t i = 0; i < 6; ++i) {
+                    command.args[i] = uint8_t((fx_val >> 4 * (5 - i)) & 0xF);
+                }
+                return true;
+            case TRANSPOSE: case RETRIEG: case DELAY_RELEASE://xx yy zz
+                command.args[0] = uint8_t(fx_val >> 4 * 4);
+                command.args[1] = uint8_t((fx_val & 0xFF00) >> 4 * 2);
+                command.args[2] = uint8_t(fx_val & 0xFF);
+                return true;
+            case PORTAMENTO://xx xx xx / 80 00 00
+                command.x = float(fx_val) / float(0x800000);
+                return true;
+            default:
+                return false;
+        }
+    }
+}
@@ -22,38 +22,70 @@ namespace C0deTracker{
 
     Instrument::~Instrument() {delete this->osc;}
 
-    Oscillator *Instrument::get_oscillator() const {return this->osc;}
+    Oscillator *Instrument::get_oscillator() {return this->osc;}
+    const Oscillator *Instrument::get_oscillator() const {return this->osc;}
+    float Instrument::getGlobalVolume() const {return this->global_volume;}
 
-    float Instrument::play_key(float a, Key k, double t) {
-        return this->global_volume * this->osc->oscillate(a, Notes::key2freq(k), t, this->osc->getDutycycle(),
+    float Instrument::play_key(VoiceState &v, float a, Key k, double t) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::key2freq(k), t, this->osc->getDutycycle(),
                                                           this->osc->getPhase());
     }
-    float Instrument::play(float a, float note, double octave, double t) {
-        return this->global_volume * this->osc->oscillate(a, Notes::key2freq(note, octave), t, this->osc->getDutycycle(),
+    float Instrument::play(VoiceState &v, float a, float note, double octave, double t) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::key2freq(note, octave), t, this->osc->getDutycycle(),
                                                           this->osc->getPhase());
     }
 
-    float Instrument::play_key(float a, Key k, double t, double rt) {
-        return this->global_volume * this->osc->oscillate(a, Notes::key2freq(k), t, rt, this->osc->getDutycycle(),
+    float Instrument::play_key(VoiceState &v, float a, Key k, double t, double rt) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::key2freq(k), t, rt, this->osc->getDutycycle(),
                                                                  this->osc->getPhase());
     }
 
-    float Instrument::play(float a, float note, float octave, double t, double rt) {
-        return this->global_volume * this->osc->oscillate(a, Notes::key2freq(note, octave), t, rt, this->osc->getDutycycle(),
+    float Instrument::play(VoiceState &v, float a, float note, float octave, double t, double rt) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::key2freq(note, octave), t, rt, this->osc->getDutycycle(),
                                                           this->osc->getPhase());
     }
 
-    float Instrument::play_pitch(float a, float p, double t) {
-        return this->global_volume * this->osc->oscillate(a, Notes::pitch2freq(p), t, this->osc->getDutycycle(),
+    float Instrument::play_pitch(VoiceState &v, float a, float p, double t) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::pitch2freq(p), t, this->osc->getDutycycle(),
                                                           this->osc->getPhase());
     }
 
-    float Instrument::play_pitch(float a, float p, double t, double rt) {
-        return this->global_volume * this->osc->oscillate(a, Notes::pitch2freq(p), t, rt, this->osc->getDutycycle(),
+    float Instrument::play_pitch(VoiceState &v, float a, float p, double t, double rt) const {
+        return this->global_volume * this->osc->oscillate(v, a, Notes::pitch2freq(p), t, rt, this->osc->getDutycycle(),
                                                           this->osc->getPhase());
     }
 
-    Instrument *Instrument::clone() {
+    void Instrument::play_pitch(VoiceState &v, float *out, size_t n, const float *a, const float *p, const double *t,
+                                const double *rt) const {
+        float f[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            Notes::pitch2freq(f, p + done, m);
+            this->play_freq(v, out + done, m, a + done, f, t + done, rt + done);
+        }
+    }
+
+    float Instrument::play_freq(VoiceState &v, float a, float f, double t) const {
+        return this->global_volume * this->osc->oscillate(v, a, f, t, this->osc->getDutycycle(), this->osc->getPhase());
+    }
+
+    float Instrument::play_freq(VoiceState &v, float a, float f, double t, double rt) const {
+        return this->global_volume * this->osc->oscillate(v, a, f, t, rt, this->osc->getDutycycle(), this->osc->getPhase());
+    }
+
+    void Instrument::play_freq(VoiceState &v, float *out, size_t n, const float *a, const float *f, const double *t,
+                               const double *rt) const {
+        this->osc->oscillate(v, out, n, a, f, t, rt, this->osc->getDutycycle(), this->osc->getPhase());
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = this->global_volume * out[k];
+        }
+    }
+
+    void Instrument::skip(VoiceState &v, size_t n, const float *f, const double *t, const double *rt) const {
+        this->osc->skip(v, n, f, t, rt, this->osc->getDutycycle(), this->osc->getPhase());
+    }
+
+    Instrument *Instrument::clone() const {
         return new Instrument(this->osc->clone(), this->global_volume);
     }
 
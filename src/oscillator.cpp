@@ -5,7 +5,7 @@
 
 /**
  * @file oscillator.cpp
- * @brief Oscillator class code (SINUS, SQUARE, TRIANGLE and WHITENOISE)
+ * @brief Oscillator class code (SINUS, SQUARE, TRIANGLE, WHITENOISE and shift register NOISE)
  * @see code_tracker.hpp
  * @author Abdulmajid, Olivier NASSER
  * @version 0.1
@@ -14,8 +14,357 @@
 
 #include "../include/c0de_tracker.hpp"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define C0DETRACKER_X86_SIMD
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 namespace C0deTracker {
 
+    /*
+     * Waveform kernels. Every waveform exists as a scalar function of one sample and as block functions rendering 8
+     * samples per iteration (SSE2 and AVX2). The block functions do exactly the same float operations in the same order
+     * as the scalar one, so all of them give the same samples (as long as the compiler does not fuse multiply-adds).
+     * The table kernels read single-cycle tables the same way, the AVX2 ones with gathers.
+     */
+    namespace {
+        typedef void (*WaveKernel)(float *out, const float *a, const float *ph, size_t n, float dc);
+        typedef void (*TableKernel)(float *out, const float *a, const float *ph, size_t n, const float *table,
+                                    float size);
+
+        //Taylor coefficients of sin(2 pi z), error below 6e-8 for z in [-0.25, 0.25]
+        const float SIN_C1 = 6.283185307f, SIN_C3 = -41.34170224f, SIN_C5 = 81.60524928f,
+                    SIN_C7 = -76.70585976f, SIN_C9 = 42.05869394f, SIN_C11 = -15.09464258f;
+
+        //sin(2 pi x) for x in [0, 1]
+        inline float sin2pi(float x) {
+            float y = x - 0.5f;//sin(2 pi x) = -sin(2 pi y)
+            y = (y > 0.25f) ? 0.5f - y : y;
+            y = (y < -0.25f) ? -0.5f - y : y;
+            float z2 = y * y;
+            float p = SIN_C11;
+            p = p * z2 + SIN_C9;
+            p = p * z2 + SIN_C7;
+            p = p * z2 + SIN_C5;
+            p = p * z2 + SIN_C3;
+            p = p * z2 + SIN_C1;
+            return -(p * y);
+        }
+
+        inline float sinus_1(float a, float ph, float dc) {
+            float m = a * 0.5f * sin2pi(ph);
+            return (ph - dc < 0) ? m : -m;
+        }
+
+        inline float square_1(float a, float ph, float dc) {
+            return (ph - dc < 0) ? a * .5f : a * -.5f;
+        }
+
+        inline float triangle_1(float a, float ph, float dc) {
+            //rising edge mirrored around phase 0, the triangle is dc wide
+            float u = (ph - dc * .5f < 0) ? ph : 1.f - ph;
+            return a * (fmaxf(1.f - 2.f * u / dc, 0.f) - 0.5f);
+        }
+
+        inline float saw_1(float a, float ph, float dc) {
+            return (ph - dc < 0) ? a * (ph / dc - 0.5f) : a * -0.5f;
+        }
+
+        inline float whitenoise_1(float a, float ph, float dc) {
+            float s = -a * 0.5f * sin2pi(ph) / (dc * 0.5f);
+            return a * (s - floorf(s) - 0.5f);
+        }
+
+        inline float whitenoise2_1(float a, float ph, float /*dc*/) {
+            float s = -a * 0.5f * sin2pi(ph);
+            return a * (s - floorf(s) - 0.5f);
+        }
+
+        //bit is the output of the shift register, 0 gives the high level like the NES
+        inline float lfsr_1(float a, float bit, float /*dc*/) {
+            return a * (0.5f - bit);
+        }
+
+        template<float (*K)(float, float, float)>
+        void scalar_block(float *out, const float *a, const float *ph, size_t n, float dc) {
+            for (size_t k = 0; k < n; ++k) {
+                out[k] = K(a[k], ph[k], dc);
+            }
+        }
+
+        //sample before the phase, held until the next one
+        inline float table_nearest_1(const float *table, float size, float a, float ph) {
+            return a * table[int(ph * size)];
+        }
+
+        //linear interpolation between the two samples around the phase
+        inline float table_linear_1(const float *table, float size, float a, float ph) {
+            float pos = ph * size;
+            auto i = int(pos);
+            float frac = pos - float(i);
+            return a * (table[i] + frac * (table[i + 1] - table[i]));
+        }
+
+        template<float (*K)(const float*, float, float, float)>
+        void scalar_table(float *out, const float *a, const float *ph, size_t n, const float *table, float size) {
+            for (size_t k = 0; k < n; ++k) {
+                out[k] = K(table, size, a[k], ph[k]);
+            }
+        }
+
+#ifdef C0DETRACKER_X86_SIMD
+        /***SSE2, two vectors of 4 samples per iteration***/
+        inline __m128 select_sse(__m128 mask, __m128 a, __m128 b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        inline __m128 floor_sse(__m128 x) {
+            __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+            //above 2^23 floats are already integers (and do not fit in int32)
+            __m128 big = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), x), _mm_set1_ps(8388608.f));
+            return select_sse(big, x, t);
+        }
+
+        inline __m128 sin2pi_sse(__m128 x) {
+            __m128 y = _mm_sub_ps(x, _mm_set1_ps(0.5f));
+            y = select_sse(_mm_cmpgt_ps(y, _mm_set1_ps(0.25f)), _mm_sub_ps(_mm_set1_ps(0.5f), y), y);
+            y = select_sse(_mm_cmplt_ps(y, _mm_set1_ps(-0.25f)), _mm_sub_ps(_mm_set1_ps(-0.5f), y), y);
+            __m128 z2 = _mm_mul_ps(y, y);
+            __m128 p = _mm_set1_ps(SIN_C11);
+            p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(SIN_C9));
+            p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(SIN_C7));
+            p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(SIN_C5));
+            p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(SIN_C3));
+            p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(SIN_C1));
+            return _mm_xor_ps(_mm_mul_ps(p, y), _mm_set1_ps(-0.f));
+        }
+
+        inline __m128 below_sse(__m128 ph, __m128 dc) {
+            return _mm_cmplt_ps(_mm_sub_ps(ph, dc), _mm_setzero_ps());
+        }
+
+        inline __m128 sinus_sse(__m128 a, __m128 ph, __m128 dc) {
+            __m128 m = _mm_mul_ps(_mm_mul_ps(a, _mm_set1_ps(0.5f)), sin2pi_sse(ph));
+            return select_sse(below_sse(ph, dc), m, _mm_xor_ps(m, _mm_set1_ps(-0.f)));
+        }
+
+        inline __m128 square_sse(__m128 a, __m128 ph, __m128 dc) {
+            return select_sse(below_sse(ph, dc), _mm_mul_ps(a, _mm_set1_ps(.5f)), _mm_mul_ps(a, _mm_set1_ps(-.5f)));
+        }
+
+        inline __m128 triangle_sse(__m128 a, __m128 ph, __m128 dc) {
+            __m128 u = select_sse(below_sse(ph, _mm_mul_ps(dc, _mm_set1_ps(.5f))), ph, _mm_sub_ps(_mm_set1_ps(1.f), ph));
+            __m128 r = _mm_sub_ps(_mm_set1_ps(1.f), _mm_div_ps(_mm_mul_ps(_mm_set1_ps(2.f), u), dc));
+            return _mm_mul_ps(a, _mm_sub_ps(_mm_max_ps(r, _mm_setzero_ps()), _mm_set1_ps(0.5f)));
+        }
+
+        inline __m128 saw_sse(__m128 a, __m128 ph, __m128 dc) {
+            __m128 rising = _mm_mul_ps(a, _mm_sub_ps(_mm_div_ps(ph, dc), _mm_set1_ps(0.5f)));
+            return select_sse(below_sse(ph, dc), rising, _mm_mul_ps(a, _mm_set1_ps(-0.5f)));
+        }
+
+        inline __m128 whitenoise_sse(__m128 a, __m128 ph, __m128 dc) {
+            __m128 s = _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(a, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f)), sin2pi_sse(ph));
+            s = _mm_div_ps(s, _mm_mul_ps(dc, _mm_set1_ps(0.5f)));
+            return _mm_mul_ps(a, _mm_sub_ps(_mm_sub_ps(s, floor_sse(s)), _mm_set1_ps(0.5f)));
+        }
+
+        inline __m128 whitenoise2_sse(__m128 a, __m128 ph, __m128 /*dc*/) {
+            __m128 s = _mm_mul_ps(_mm_mul_ps(_mm_xor_ps(a, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f)), sin2pi_sse(ph));
+            return _mm_mul_ps(a, _mm_sub_ps(_mm_sub_ps(s, floor_sse(s)), _mm_set1_ps(0.5f)));
+        }
+
+        inline __m128 lfsr_sse(__m128 a, __m128 bit, __m128 /*dc*/) {
+            return _mm_mul_ps(a, _mm_sub_ps(_mm_set1_ps(0.5f), bit));
+        }
+
+        template<__m128 (*V)(__m128, __m128, __m128), float (*K)(float, float, float)>
+        void sse_block(float *out, const float *a, const float *ph, size_t n, float dc) {
+            __m128 vdc = _mm_set1_ps(dc);
+            size_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                _mm_storeu_ps(out + k, V(_mm_loadu_ps(a + k), _mm_loadu_ps(ph + k), vdc));
+                _mm_storeu_ps(out + k + 4, V(_mm_loadu_ps(a + k + 4), _mm_loadu_ps(ph + k + 4), vdc));
+            }
+            for (; k < n; ++k) {
+                out[k] = K(a[k], ph[k], dc);
+            }
+        }
+
+        //SSE2 has no gather, the 4 samples are loaded one by one
+        inline __m128 table_nearest_sse(const float *table, __m128 size, __m128 a, __m128 ph) {
+            alignas(16) int32_t i[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(i), _mm_cvttps_epi32(_mm_mul_ps(ph, size)));
+            return _mm_mul_ps(a, _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]));
+        }
+
+        inline __m128 table_linear_sse(const float *table, __m128 size, __m128 a, __m128 ph) {
+            __m128 pos = _mm_mul_ps(ph, size);
+            __m128i vi = _mm_cvttps_epi32(pos);
+            __m128 frac = _mm_sub_ps(pos, _mm_cvtepi32_ps(vi));
+            alignas(16) int32_t i[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(i), vi);
+            __m128 x0 = _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+            __m128 x1 = _mm_setr_ps(table[i[0] + 1], table[i[1] + 1], table[i[2] + 1], table[i[3] + 1]);
+            return _mm_mul_ps(a, _mm_add_ps(x0, _mm_mul_ps(frac, _mm_sub_ps(x1, x0))));
+        }
+
+        template<__m128 (*V)(const float*, __m128, __m128, __m128), float (*K)(const float*, float, float, float)>
+        void sse_table(float *out, const float *a, const float *ph, size_t n, const float *table, float size) {
+            __m128 vsize = _mm_set1_ps(size);
+            size_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                _mm_storeu_ps(out + k, V(table, vsize, _mm_loadu_ps(a + k), _mm_loadu_ps(ph + k)));
+                _mm_storeu_ps(out + k + 4, V(table, vsize, _mm_loadu_ps(a + k + 4), _mm_loadu_ps(ph + k + 4)));
+            }
+            for (; k < n; ++k) {
+                out[k] = K(table, size, a[k], ph[k]);
+            }
+        }
+
+        /***AVX2, one vector of 8 samples per iteration***/
+        TARGET_AVX2 inline __m256 sin2pi_avx(__m256 x) {
+            __m256 y = _mm256_sub_ps(x, _mm256_set1_ps(0.5f));
+            y = _mm256_blendv_ps(y, _mm256_sub_ps(_mm256_set1_ps(0.5f), y), _mm256_cmp_ps(y, _mm256_set1_ps(0.25f), _CMP_GT_OQ));
+            y = _mm256_blendv_ps(y, _mm256_sub_ps(_mm256_set1_ps(-0.5f), y), _mm256_cmp_ps(y, _mm256_set1_ps(-0.25f), _CMP_LT_OQ));
+            __m256 z2 = _mm256_mul_ps(y, y);
+            __m256 p = _mm256_set1_ps(SIN_C11);
+            p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(SIN_C9));
+            p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(SIN_C7));
+            p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(SIN_C5));
+            p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(SIN_C3));
+            p = _mm256_add_ps(_mm256_mul_ps(p, z2), _mm256_set1_ps(SIN_C1));
+            return _mm256_xor_ps(_mm256_mul_ps(p, y), _mm256_set1_ps(-0.f));
+        }
+
+        TARGET_AVX2 inline __m256 below_avx(__m256 ph, __m256 dc) {
+            return _mm256_cmp_ps(_mm256_sub_ps(ph, dc), _mm256_setzero_ps(), _CMP_LT_OQ);
+        }
+
+        TARGET_AVX2 inline __m256 sinus_avx(__m256 a, __m256 ph, __m256 dc) {
+            __m256 m = _mm256_mul_ps(_mm256_mul_ps(a, _mm256_set1_ps(0.5f)), sin2pi_avx(ph));
+            return _mm256_blendv_ps(_mm256_xor_ps(m, _mm256_set1_ps(-0.f)), m, below_avx(ph, dc));
+        }
+
+        TARGET_AVX2 inline __m256 square_avx(__m256 a, __m256 ph, __m256 dc) {
+            return _mm256_blendv_ps(_mm256_mul_ps(a, _mm256_set1_ps(-.5f)), _mm256_mul_ps(a, _mm256_set1_ps(.5f)), below_avx(ph, dc));
+        }
+
+        TARGET_AVX2 inline __m256 triangle_avx(__m256 a, __m256 ph, __m256 dc) {
+            __m256 u = _mm256_blendv_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), ph), ph, below_avx(ph, _mm256_mul_ps(dc, _mm256_set1_ps(.5f))));
+            __m256 r = _mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(2.f), u), dc));
+            return _mm256_mul_ps(a, _mm256_sub_ps(_mm256_max_ps(r, _mm256_setzero_ps()), _mm256_set1_ps(0.5f)));
+        }
+
+        TARGET_AVX2 inline __m256 saw_avx(__m256 a, __m256 ph, __m256 dc) {
+            __m256 rising = _mm256_mul_ps(a, _mm256_sub_ps(_mm256_div_ps(ph, dc), _mm256_set1_ps(0.5f)));
+            return _mm256_blendv_ps(_mm256_mul_ps(a, _mm256_set1_ps(-0.5f)), rising, below_avx(ph, dc));
+        }
+
+        TARGET_AVX2 inline __m256 whitenoise_avx(__m256 a, __m256 ph, __m256 dc) {
+            __m256 s = _mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(a, _mm256_set1_ps(-0.f)), _mm256_set1_ps(0.5f)), sin2pi_avx(ph));
+            s = _mm256_div_ps(s, _mm256_mul_ps(dc, _mm256_set1_ps(0.5f)));
+            return _mm256_mul_ps(a, _mm256_sub_ps(_mm256_sub_ps(s, _mm256_floor_ps(s)), _mm256_set1_ps(0.5f)));
+        }
+
+        TARGET_AVX2 inline __m256 whitenoise2_avx(__m256 a, __m256 ph, __m256 /*dc*/) {
+            __m256 s = _mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(a, _mm256_set1_ps(-0.f)), _mm256_set1_ps(0.5f)), sin2pi_avx(ph));
+            return _mm256_mul_ps(a, _mm256_sub_ps(_mm256_sub_ps(s, _mm256_floor_ps(s)), _mm256_set1_ps(0.5f)));
+        }
+
+        TARGET_AVX2 inline __m256 lfsr_avx(__m256 a, __m256 bit, __m256 /*dc*/) {
+            return _mm256_mul_ps(a, _mm256_sub_ps(_mm256_set1_ps(0.5f), bit));
+        }
+
+        template<__m256 (*V)(__m256, __m256, __m256), float (*K)(float, float, float)>
+        TARGET_AVX2 void avx_block(float *out, const float *a, const float *ph, size_t n, float dc) {
+            __m256 vdc = _mm256_set1_ps(dc);
+            size_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                _mm256_storeu_ps(out + k, V(_mm256_loadu_ps(a + k), _mm256_loadu_ps(ph + k), vdc));
+            }
+            for (; k < n; ++k) {
+                out[k] = K(a[k], ph[k], dc);
+            }
+        }
+
+        TARGET_AVX2 inline __m256 table_nearest_avx(const float *table, __m256 size, __m256 a, __m256 ph) {
+            return _mm256_mul_ps(a, _mm256_i32gather_ps(table, _mm256_cvttps_epi32(_mm256_mul_ps(ph, size)), 4));
+        }
+
+        TARGET_AVX2 inline __m256 table_linear_avx(const float *table, __m256 size, __m256 a, __m256 ph) {
+            __m256 pos = _mm256_mul_ps(ph, size);
+            __m256i i = _mm256_cvttps_epi32(pos);
+            __m256 frac = _mm256_sub_ps(pos, _mm256_cvtepi32_ps(i));
+            __m256 x0 = _mm256_i32gather_ps(table, i, 4);
+            __m256 x1 = _mm256_i32gather_ps(table + 1, i, 4);
+            return _mm256_mul_ps(a, _mm256_add_ps(x0, _mm256_mul_ps(frac, _mm256_sub_ps(x1, x0))));
+        }
+
+        template<__m256 (*V)(const float*, __m256, __m256, __m256), float (*K)(const float*, float, float, float)>
+        TARGET_AVX2 void avx_table(float *out, const float *a, const float *ph, size_t n, const float *table,
+                                   float size) {
+            __m256 vsize = _mm256_set1_ps(size);
+            size_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                _mm256_storeu_ps(out + k, V(table, vsize, _mm256_loadu_ps(a + k), _mm256_loadu_ps(ph + k)));
+            }
+            for (; k < n; ++k) {
+                out[k] = K(table, size, a[k], ph[k]);
+            }
+        }
+#endif
+
+        struct KernelTable {
+            const char *name;
+            WaveKernel kernel[WAVETYPES];
+            TableKernel table[2];//holding the samples, interpolating them
+        };
+
+        const KernelTable SCALAR_KERNELS = {"scalar", {scalar_block<sinus_1>, scalar_block<square_1>,
+                                                       scalar_block<triangle_1>, scalar_block<saw_1>,
+                                                       scalar_block<whitenoise_1>, scalar_block<whitenoise2_1>,
+                                                       scalar_block<lfsr_1>, scalar_block<lfsr_1>},
+                                           {scalar_table<table_nearest_1>, scalar_table<table_linear_1>}};
+#ifdef C0DETRACKER_X86_SIMD
+        const KernelTable SSE2_KERNELS = {"SSE2", {sse_block<sinus_sse, sinus_1>, sse_block<square_sse, square_1>,
+                                                   sse_block<triangle_sse, triangle_1>, sse_block<saw_sse, saw_1>,
+                                                   sse_block<whitenoise_sse, whitenoise_1>,
+                                                   sse_block<whitenoise2_sse, whitenoise2_1>,
+                                                   sse_block<lfsr_sse, lfsr_1>, sse_block<lfsr_sse, lfsr_1>},
+                                           {sse_table<table_nearest_sse, table_nearest_1>,
+                                            sse_table<table_linear_sse, table_linear_1>}};
+        const KernelTable AVX2_KERNELS = {"AVX2", {avx_block<sinus_avx, sinus_1>, avx_block<square_avx, square_1>,
+                                                   avx_block<triangle_avx, triangle_1>, avx_block<saw_avx, saw_1>,
+                                                   avx_block<whitenoise_avx, whitenoise_1>,
+                                                   avx_block<whitenoise2_avx, whitenoise2_1>,
+                                                   avx_block<lfsr_avx, lfsr_1>, avx_block<lfsr_avx, lfsr_1>},
+                                           {avx_table<table_nearest_avx, table_nearest_1>,
+                                            avx_table<table_linear_avx, table_linear_1>}};
+#endif
+
+        //best kernels for the CPU running the program, chosen once at startup
+        const KernelTable *bestKernels() {
+#ifdef C0DETRACKER_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return &AVX2_KERNELS;
+            }
+            return &SSE2_KERNELS;
+#else
+            return &SCALAR_KERNELS;
+#endif
+        }
+
+        //switched by enableSimd while other threads may be rendering, read once per block
+        std::atomic<const KernelTable*> &activeKernels() {
+            static std::atomic<const KernelTable*> kernels(bestKernels());
+            return kernels;
+        }
+    }
+
     Oscillator::Oscillator(uint_fast8_t wavetype){ this->wavetype = wavetype;}
     Oscillator::Oscillator(uint_fast8_t wavetype, float dc) {this->wavetype = wavetype; this->dutycycle = dc;}
     Oscillator::Oscillator(uint_fast8_t wavetype, float dc, float p) {this->wavetype = wavetype; this->dutycycle = dc; this->phase = p;}
@@ -23,74 +372,166 @@ namespace C0deTracker {
     Oscillator::~Oscillator() = default;
 
     void Oscillator::setWavetype(uint_fast8_t wavetype) { this->wavetype = wavetype;}
-    uint_fast8_t Oscillator::getWavetype() {return this->wavetype;}
+    uint_fast8_t Oscillator::getWavetype() const {return this->wavetype;}
 
     void Oscillator::setDutycycle(float dc) { this->dutycycle = dc;}
-    float Oscillator::getDutycycle() {return this->dutycycle;}
+    float Oscillator::getDutycycle() const {return this->dutycycle;}
 
     void Oscillator::setPhase(float p) { this->phase = p;}
-    float Oscillator::getPhase() {return this->phase;}
+    float Oscillator::getPhase() const {return this->phase;}
 
-    float Oscillator::oscillate(float a, float f, double t, float dc, float p) {
+    const char *Oscillator::getInstructionSet() {return activeKernels().load(std::memory_order_acquire)->name;}
+
+    void Oscillator::enableSimd(bool enable) {
+        activeKernels().store(enable ? bestKernels() : &SCALAR_KERNELS, std::memory_order_release);
+    }
+
+    void Oscillator::accumulatePhase(VoiceState &v, float f, double t, float dc) const {
+        if (t < v.phase_time) {//new note (or retrieg), the waveform starts again from phase 0
+            v.phase_acc = 0.;
+            v.phase_time = 0.;
+            v.lfsr = LFSR_SEED;
+        }
+        //the white noise 2 sinus runs at f / dc
+        double inc = (this->wavetype == WHITENOISE2) ? double(f) / dc : double(f);
+        v.phase_acc += inc * (t - v.phase_time);
+        v.phase_time = t;
+        if (v.phase_acc >= 1.) {
+            double periods = floor(v.phase_acc);
+            if (this->wavetype == NOISE_LONG || this->wavetype == NOISE_SHORT) {
+                this->clockNoise(v, periods);
+            }
+            v.phase_acc -= periods;
+        }
+    }
+
+    void Oscillator::clockNoise(VoiceState &v, double clocks) const {
+        bool short_mode = this->wavetype == NOISE_SHORT;
+        uint_fast8_t tap = short_mode ? LFSR_SHORT_TAP : LFSR_LONG_TAP;
+        //whole periods give the same register, so a long skip costs at most one period
+        auto count = uint_fast32_t(fmod(clocks, short_mode ? LFSR_SHORT_PERIOD : LFSR_LONG_PERIOD));
+        uint_fast16_t r = v.lfsr;
+        for (uint_fast32_t i = 0; i < count; ++i) {
+            uint_fast16_t feedback = (r ^ (r >> tap)) & 1u;
+            r = (r >> 1) | (feedback << 14);
+        }
+        v.lfsr = uint16_t(r);
+    }
+
+    float Oscillator::advancePhase(VoiceState &v, float f, double t, float dc, float p) const {
+        this->accumulatePhase(v, f, t, dc);
+        if (this->wavetype == NOISE_LONG || this->wavetype == NOISE_SHORT) {//the kernel only needs the output bit
+            return float(v.lfsr & 1u);
+        }
+        double shift = (this->wavetype == WHITENOISE2) ? double(p) / dc : double(p);
+        double ph = v.phase_acc - shift;
+        return float(ph - floor(ph));
+    }
+
+    float Oscillator::oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const {
+        float ph = this->advancePhase(v, f, t, dc, p);
         switch(this->wavetype){
             case SINUS:
-                return Oscillator::sinus(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::sinus(a, ph, dc, 0.f);
             case SQUARE:
-                return Oscillator::square(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::square(a, ph, dc, 0.f);
             case TRIANGLE:
-                return Oscillator::triangle(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::triangle(a, ph, dc, 0.f);
             case SAW:
-                return Oscillator::saw(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::saw(a, ph, dc, 0.f);
             case WHITENOISE:
-                return Oscillator::whitenoise(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::whitenoise(a, ph, dc, 0.f);
             case WHITENOISE2:
-                return Oscillator::whitenoise2(a, f, t - p*1./f, dc, 0.f);
+                return Oscillator::whitenoise2(a, ph, dc, 0.f);
+            case NOISE_LONG: case NOISE_SHORT:
+                return Oscillator::lfsrNoise(a, ph, dc, 0.f);
             default:
                 return 0;
         }
     }
 
-    float Oscillator::sinus(float a, float f, double t, float dc, float FMfeed) {
-        double frac_ft = f * t - floor(t/(1.f/f));
-        return (frac_ft - dc < 0) ? a * 0.5 * sinf(TWOPI * f * t + FMfeed) : - a * 0.5 *(sinf(TWOPI * f * t + FMfeed));
-        //return a * 0.5 * sinf(TWOPI * f * t + FMfeed);
+    void Oscillator::oscillate(VoiceState &v, float *out, size_t n, const float *a, const float *f, const double *t,
+                               const double * /*rt*/, float dc, float p) const {
+        if (this->wavetype >= WAVETYPES) {
+            for (size_t k = 0; k < n; ++k) { out[k] = 0.f; }
+            return;
+        }
+        const KernelTable *kernels = activeKernels().load(std::memory_order_acquire);
+        float ph[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            for (size_t k = 0; k < m; ++k) {
+                ph[k] = this->advancePhase(v, f[done + k], t[done + k], dc, p);
+            }
+            kernels->kernel[this->wavetype](out + done, a + done, ph, m, dc);
+        }
+    }
+
+    void Oscillator::skip(VoiceState &v, size_t n, const float *f, const double *t, const double * /*rt*/, float dc,
+                          float /*p*/) const {
+        if (this->wavetype >= WAVETYPES) {
+            return;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            this->accumulatePhase(v, f[k], t[k], dc);
+        }
+    }
+
+    void Oscillator::readTable(float *out, size_t n, const float *a, const float *ph, const float *table,
+                               size_t length, bool interpolate) {
+        activeKernels().load(std::memory_order_acquire)->table[interpolate ? 1 : 0](out, a, ph, n, table,
+                                                                                  float(length));
     }
 
-    float Oscillator::square(float a, float f, double t, float dc, float FMfeed) {
-        double frac_ft = f * t - floor(t/(1.f/f));
-        return (frac_ft -dc < 0) ?  a * .5f + FMfeed : a * -.5f + FMfeed;
+    void Oscillator::applyAmpEnvelope(VoiceState &v, float *out, size_t n, const double *t, const double *rt) const {
+        float envelope[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            this->getAmpEnvelope()->render(v, envelope, m, t + done, rt + done);
+            for (size_t k = 0; k < m; ++k) {
+                out[done + k] = MASTER_VOLUME * envelope[k] * out[done + k];
+            }
+        }
     }
 
-    float Oscillator::triangle(float a, float f, double t, float dc, float FMfeed) {
-        //t-T*floor(t/T)  <=> mod(t,T)
-        double frac_ft = f * t - floor(t*f);
-        double s = (frac_ft - dc * .5 < 0) ? t + FMfeed : -t + FMfeed;
-        double frac_fs = f*s - floor(f*s);
-        return  float(double(a) * (std::fmax(1. - 2*frac_fs/dc, -0.) - 0.5));
+    void Oscillator::skipAmpEnvelope(VoiceState &v, size_t n, const double *t, const double *rt) const {
+        //the envelope goes through every sample, its segments are only known by running them
+        float envelope[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            this->getAmpEnvelope()->render(v, envelope, m, t + done, rt + done);
+        }
     }
 
-    float Oscillator::saw(float a, float f, double t, float dc, float FMfeed) {
-        double T = 1.f / f;
-        //t-T*floor(t/T)  <=> mod(t,T)
-        double frac_ft = f * t - floor( t / (1.f/f));
-        double s = (frac_ft - dc < 0) ? t + FMfeed : 0.f + FMfeed;
-        double frac_fs = f * s - floor( s / (1.f/f));
-        return  float(double(a) * ( frac_fs / (dc) - 0.5));
+    float Oscillator::sinus(float a, float ph, float dc, float FMfeed) {
+        return sinus_1(a, ph + FMfeed, dc);
+    }
+
+    float Oscillator::square(float a, float ph, float dc, float FMfeed) {
+        return square_1(a, ph, dc) + FMfeed;
+    }
+
+    float Oscillator::triangle(float a, float ph, float dc, float FMfeed) {
+        return triangle_1(a, ph + FMfeed, dc);
+    }
+
+    float Oscillator::saw(float a, float ph, float dc, float FMfeed) {
+        return saw_1(a, ph + FMfeed, dc);
+    }
 
+    float Oscillator::whitenoise(float a, float ph, float dc, float FMfeed) {
+        return whitenoise_1(a, ph + FMfeed, dc);
     }
 
-    float Oscillator::whitenoise(float a, float f, double t, float dc, float FMfeed) {
-        float s = Oscillator::sinus(a, f, t, 0.f, FMfeed)/(dc*0.5);
-        //s = this->sinus(a, f, t/(dc), 0.f, FMfeed);
-        return  a * (s - floor(s) - 0.5);
+    float Oscillator::whitenoise2(float a, float ph, float dc, float FMfeed) {
+        return whitenoise2_1(a, ph + FMfeed, dc);
     }
 
-    float Oscillator::whitenoise2(float a, float f, double t, float dc, float FMfeed) {
-        float s = Oscillator::sinus(a, f, t/dc, 0.f, FMfeed);
-        return  a * (s - floor(s) - 0.5);
+    float Oscillator::lfsrNoise(float a, float bit, float dc, float FMfeed) {
+        return lfsr_1(a, bit, dc) + FMfeed;
     }
 
 
 
 
-}
\ No newline at end of file
+}
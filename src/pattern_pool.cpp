@@ -0,0 +1,58 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include <cstring>
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file pattern_pool.cpp
+ * @brief PatternPool class code
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+namespace C0deTracker {
+
+    PatternPool::PatternPool(uint_fast8_t rows) : rows(rows), empty(rows) {
+        this->add(this->empty.data());
+    }
+
+    uint_fast16_t PatternPool::add(const Instruction *rows) {
+        uint64_t h = this->hash(rows);
+        auto same = this->hashes.equal_range(h);
+        for (auto it = same.first; it != same.second; ++it) {
+            if (std::memcmp(this->patterns[it->second], rows, this->rows * sizeof(Instruction)) == 0) {
+                return it->second;
+            }
+        }
+        auto index = uint_fast16_t(this->patterns.size());
+        this->patterns.push_back(rows);
+        this->hashes.emplace(h, index);
+        return index;
+    }
+
+    uint_fast16_t PatternPool::size() const {
+        return uint_fast16_t(this->patterns.size());
+    }
+
+    const Instruction *PatternPool::getRows(uint_fast16_t index) const {
+        return this->patterns[index];
+    }
+
+    uint64_t PatternPool::hash(const Instruction *rows) const {
+        //FNV-1a of the bytes of the rows, the rows have no padding
+        const auto *bytes = reinterpret_cast<const uint8_t*>(rows);
+        uint64_t h = FNV_OFFSET_BASIS;
+        for (size_t i = 0; i < this->rows * sizeof(Instruction); ++i) {
+            h = (h ^ bytes[i]) * FNV_PRIME;
+        }
+        return h;
+    }
+}
@@ -22,48 +22,38 @@ namespace C0deTracker {
 
     PSG::~PSG() {Oscillator::~Oscillator();}
 
-    float PSG::handleAmpEnvelope(double t, double rt) {
-        float output = MASTER_VOLUME;
-        float attacktime = MASTER_VOLUME / this->amp_envelope.attack;
-        float attack_amp = fmin(MASTER_VOLUME, t*this->amp_envelope.attack);
-        if(this->release && rt >= 0.f){//release
-            output *= fmax(0.f, this->current_envelope_amplitude - (rt) * this->amp_envelope.release);
-        }else{
-            if(attack_amp < MASTER_VOLUME){//attack
-                output *= attack_amp;
-                this->current_envelope_amplitude = output;
-            }else{//decay sustain
-                output *= fmax(this->amp_envelope.sustain, MASTER_VOLUME - (t - attacktime) * this->amp_envelope.decay);
-                this->current_envelope_amplitude = output;
-            }
-        }
-        return output;
+    float PSG::handleAmpEnvelope(VoiceState &v, double t, double rt) const {
+        float output;
+        this->amp_envelope.render(v, &output, 1, &t, &rt);
+        return MASTER_VOLUME * output;
     }
 
-
-
-    float PSG::oscillate(float a, float f, double t, double rt, float dc, float p) {
-        return this->handleAmpEnvelope(t, rt) * Oscillator::oscillate(a, f, t, dc, p);;
+    float PSG::oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const {
+        return this->handleAmpEnvelope(v, t, rt) * Oscillator::oscillate(v, a, f, t, dc, p);;
     }
 
-    float PSG::oscillate(float a, float f, double t, float dc, float p) {
-        return this->oscillate(a, f, t, -1.f, dc, p);
+    void PSG::oscillate(VoiceState &v, float *out, size_t n, const float *a, const float *f, const double *t,
+                        const double *rt, float dc, float p) const {
+        Oscillator::oscillate(v, out, n, a, f, t, rt, dc, p);
+        this->applyAmpEnvelope(v, out, n, t, rt);
     }
 
-    void PSG::setRelease(bool r) {
-        this->release = r;
+    void PSG::skip(VoiceState &v, size_t n, const float *f, const double *t, const double *rt, float dc,
+                   float p) const {
+        Oscillator::skip(v, n, f, t, rt, dc, p);
+        this->skipAmpEnvelope(v, n, t, rt);
     }
 
-    ADSR* PSG::getAmpEnvelope() {
-        return (&this->amp_envelope);
+    float PSG::oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const {
+        return this->oscillate(v, a, f, t, -1.f, dc, p);
     }
 
-    bool PSG::isReleased() {
-        return this->release;
+    const ADSR* PSG::getAmpEnvelope() const {
+        return (&this->amp_envelope);
     }
 
-    PSG * PSG::clone() {
-        return new PSG(Oscillator::getWavetype(), Oscillator::getDutycycle(), Oscillator::getPhase(), this->amp_envelope);
+    PSG * PSG::clone() const {
+        return new PSG(*this);
     }
 
 
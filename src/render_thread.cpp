@@ -0,0 +1,90 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+#include <chrono>
+
+/**
+ * @file render_thread.cpp
+ * @brief RenderThread class code
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    RenderThread::RenderThread(Track *track, Channel *chan, uint_fast8_t size_of_chans, double sample_rate,
+                               size_t lookahead) : ring(2 * (lookahead + RENDER_BLOCK_SIZE)) {
+        this->track = track;
+        this->chan = chan;
+        this->size_of_chans = size_of_chans;
+        this->sample_rate = sample_rate;
+        this->max_lookahead = lookahead;
+        this->lookahead.store(lookahead);
+    }
+
+    RenderThread::~RenderThread() {
+        this->stop();
+    }
+
+    void RenderThread::start(double t) {
+        this->stop();
+        this->start_time = t;
+        this->running.store(true);
+        this->thread = std::thread(&RenderThread::work, this);
+    }
+
+    void RenderThread::stop() {
+        this->running.store(false);
+        if (this->thread.joinable()) {
+            this->thread.join();
+        }
+        this->ring.clear();
+    }
+
+    void RenderThread::seek(double t) {
+        this->stop();
+        this->track->seek(t, this->sample_rate, this->chan, this->size_of_chans);
+        this->start(t);
+    }
+
+    size_t RenderThread::pull(float *out, size_t frames) {
+        size_t ready = this->ring.read(out, 2 * frames) / 2;
+        for (size_t k = 2 * ready; k < 2 * frames; ++k) {
+            out[k] = 0.f;
+        }
+        if (ready < frames) {
+            this->underruns.fetch_add(frames - ready, std::memory_order_relaxed);
+        }
+        return ready;
+    }
+
+    void RenderThread::setLookahead(size_t frames) {
+        this->lookahead.store((frames < this->max_lookahead) ? frames : this->max_lookahead);
+    }
+
+    size_t RenderThread::getUnderruns() const {
+        return this->underruns.load(std::memory_order_relaxed);
+    }
+
+    void RenderThread::work() {
+        float block[2 * RENDER_BLOCK_SIZE];
+        size_t rendered = 0;
+        //when the look-ahead is full, check again a quarter of a block later
+        std::chrono::duration<double> nap(RENDER_BLOCK_SIZE / (4. * this->sample_rate));
+        while (this->running.load()) {
+            if (this->ring.available() >= 2 * this->lookahead.load(std::memory_order_relaxed) ||
+                this->ring.space() < 2 * RENDER_BLOCK_SIZE) {
+                std::this_thread::sleep_for(nap);
+                continue;
+            }
+            this->track->render(block, RENDER_BLOCK_SIZE, this->start_time + double(rendered) / this->sample_rate,
+                                this->sample_rate, this->chan, this->size_of_chans);
+            this->ring.write(block, 2 * RENDER_BLOCK_SIZE);
+            rendered += RENDER_BLOCK_SIZE;
+        }
+    }
+}
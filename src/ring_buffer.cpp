@@ -0,0 +1,66 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file ring_buffer.cpp
+ * @brief RingBuffer class code
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    RingBuffer::RingBuffer(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        this->buffer.resize(size);
+        this->mask = size - 1;
+    }
+
+    size_t RingBuffer::write(const float *data, size_t n) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        size_t tail = this->tail.load(std::memory_order_acquire);
+        size_t space = this->buffer.size() - (head - tail);
+        if (n > space) {
+            n = space;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            this->buffer[(head + k) & this->mask] = data[k];
+        }
+        this->head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t RingBuffer::read(float *data, size_t n) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        size_t head = this->head.load(std::memory_order_acquire);
+        if (n > head - tail) {
+            n = head - tail;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            data[k] = this->buffer[(tail + k) & this->mask];
+        }
+        this->tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t RingBuffer::available() const {
+        return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire);
+    }
+
+    size_t RingBuffer::space() const {
+        return this->buffer.size() - this->available();
+    }
+
+    void RingBuffer::clear() {
+        this->head.store(0);
+        this->tail.store(0);
+    }
+}
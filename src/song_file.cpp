@@ -0,0 +1,303 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include <cstring>
+
+#include "../include/c0de_tracker.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @file song_file.cpp
+ * @brief SongFile class code, .ctk files
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define CTK_MAGIC "C0TK"
+#define CTK_BYTE_ORDER 0x01020304u
+#define CTK_ROWS_ALIGNMENT 64
+#define CTK_PSG 0
+#define CTK_BAND_LIMITED_PSG 1
+#define CTK_LINEAR_VERSION 2 //last version without ADSR curves, still loaded with linear envelopes
+
+namespace C0deTracker {
+
+    struct FileHeader{
+        char magic[4];
+        uint32_t version;
+        uint32_t byte_order;//CTK_BYTE_ORDER as written by the machine which saved the file
+        uint32_t row_size;//sizeof(Instruction)
+        uint64_t file_size;
+        float clock, basetime, speed;
+        uint8_t rows, frames, channels, instruments;
+        uint32_t instruments_offset, effects_offset, order_offset, rows_offset;
+        uint32_t slots_offset;//pattern of the pool used by each channel * frames + pattern
+        uint16_t patterns;//patterns in the pool, the empty one included
+        uint8_t reserved[2];
+    };
+
+    struct FileInstrument{
+        uint8_t oscillator;//CTK_PSG or CTK_BAND_LIMITED_PSG
+        uint8_t wavetype;
+        uint8_t curve;//ADSR::Curves since version 3, a reserved byte in version 2
+        uint8_t reserved;
+        float dutycycle, phase, attack, decay, sustain, release, volume;
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "the .ctk header is 64 bytes");
+    static_assert(sizeof(FileInstrument) == 32, "a .ctk instrument is 32 bytes");
+    static_assert(sizeof(Instruction) == 32, "rows are mapped as they are in .ctk files");
+    static_assert(sizeof(uint_fast8_t) == 1, "pattern indices are mapped as they are in .ctk files");
+    static_assert(size_t(uint8_t(-1)) * uint8_t(-1) <= uint16_t(-1), "the pool of any song fits 16 bits slots");
+
+    /**
+     * @return nullptr if the mapped file is a valid .ctk file of this version or of CTK_LINEAR_VERSION, otherwise the
+     * reason why it is not
+     */
+    static const char* check(const uint8_t *data, size_t size) {
+        if (size < sizeof(FileHeader)) {
+            return "file too small";
+        }
+        const auto *header = reinterpret_cast<const FileHeader*>(data);
+        if (std::memcmp(header->magic, CTK_MAGIC, 4) != 0) {
+            return "not a .ctk file";
+        }
+        if (header->byte_order != CTK_BYTE_ORDER) {
+            return "written with another byte order";
+        }
+        if ((header->version != CTK_VERSION && header->version != CTK_LINEAR_VERSION) ||
+            header->row_size != sizeof(Instruction)) {
+            return "written by another version of C0deTracker";
+        }
+        if (header->file_size != size) {
+            return "truncated file";
+        }
+        if (header->rows == 0 || header->frames == 0 || header->channels == 0 || header->patterns == 0) {
+            return "empty song";
+        }
+        //a row lasts basetime * speed / clock seconds and a tick 1 / clock
+        if (!std::isfinite(header->clock) || !std::isfinite(header->basetime) || !std::isfinite(header->speed) ||
+            !(header->clock > 0.f) || !(header->basetime > 0.f) || !(header->speed > 0.f)) {
+            return "invalid tempo";
+        }
+        size_t patterns = size_t(header->channels) * header->frames;
+        if (header->instruments_offset % alignof(FileInstrument) != 0 ||
+            header->instruments_offset + size_t(header->instruments) * sizeof(FileInstrument) > size ||
+            header->effects_offset + size_t(header->channels) > size || header->order_offset + patterns > size ||
+            header->slots_offset % alignof(uint16_t) != 0 ||
+            header->slots_offset + patterns * sizeof(uint16_t) > size ||
+            header->rows_offset % CTK_ROWS_ALIGNMENT != 0 ||
+            header->rows_offset + size_t(header->patterns) * header->rows * sizeof(Instruction) > size) {
+            return "section out of the file";
+        }
+        const auto *slots = reinterpret_cast<const uint16_t*>(data + header->slots_offset);
+        for (size_t i = 0; i < patterns; ++i) {
+            if (data[header->order_offset + i] >= header->frames || slots[i] >= header->patterns) {
+                return "pattern index out of range";
+            }
+        }
+        const auto *instruments = reinterpret_cast<const FileInstrument*>(data + header->instruments_offset);
+        for (uint_fast8_t i = 0; i < header->instruments; ++i) {
+            if (instruments[i].oscillator > CTK_BAND_LIMITED_PSG || instruments[i].wavetype >= WAVETYPES ||
+                (header->version != CTK_LINEAR_VERSION && instruments[i].curve >= ADSR::CURVES)) {
+                return "unknown instrument";
+            }
+        }
+        return nullptr;
+    }
+
+    Track *SongFile::load(const char *path) {
+        auto *file = new SongFile(path);
+        if (file->data == nullptr) {
+            delete file;
+            return nullptr;
+        }
+        const char *error = check(file->data, file->size);
+        if (error != nullptr) {
+            fprintf(stderr, "C0deTracker : %s : %s\n", path, error);
+            delete file;
+            return nullptr;
+        }
+        const auto *header = reinterpret_cast<const FileHeader*>(file->data);
+        //the rows, the order list and the effects are used in place, from the read-only mapping
+        const auto *rows = reinterpret_cast<const Instruction*>(file->data + header->rows_offset);
+        const auto *slots = reinterpret_cast<const uint16_t*>(file->data + header->slots_offset);
+        const auto *order = reinterpret_cast<const uint_fast8_t*>(file->data + header->order_offset);
+        const auto *effects_per_chan = reinterpret_cast<const uint_fast8_t*>(file->data + header->effects_offset);
+
+        const auto *instruments = reinterpret_cast<const FileInstrument*>(file->data + header->instruments_offset);
+        auto **instruments_bank = new Instrument*[header->instruments];
+        for (uint_fast8_t i = 0; i < header->instruments; ++i) {
+            const FileInstrument &instrument = instruments[i];
+            uint_fast8_t curve = (header->version == CTK_LINEAR_VERSION) ? uint_fast8_t(ADSR::LINEAR) : instrument.curve;
+            ADSR envelope(instrument.attack, instrument.decay, instrument.sustain, instrument.release, curve);
+            PSG *psg;
+            if (instrument.oscillator == CTK_BAND_LIMITED_PSG) {
+                psg = new BandLimitedPSG(instrument.wavetype, instrument.dutycycle, instrument.phase, envelope);
+            } else {
+                psg = new PSG(instrument.wavetype, instrument.dutycycle, instrument.phase, envelope);
+            }
+            instruments_bank[i] = new Instrument(psg, instrument.volume);
+        }
+
+        auto *track = new Track(header->clock, header->basetime, header->speed, header->rows, header->frames,
+                                header->channels, instruments_bank, header->instruments, rows, slots,
+                                order, effects_per_chan);
+        track->file = file;
+        return track;
+    }
+
+    bool SongFile::save(Track &track, const char *path) {
+        size_t patterns = size_t(track.channels) * track.frames;
+        //only the patterns played are written, each different one once
+        PatternPool pool(track.rows);
+        std::vector<uint16_t> slots(patterns, EMPTY_PATTERN);
+        for (size_t i = 0; i < patterns; ++i) {
+            size_t slot = i - i % track.frames + *track.pattern_indices[i];
+            if (slot < patterns) {
+                slots[slot] = uint16_t(pool.add(track.track_patterns[slot]->instructions));
+            }
+        }
+
+        FileHeader header{};
+        std::memcpy(header.magic, CTK_MAGIC, 4);
+        header.version = CTK_VERSION;
+        header.byte_order = CTK_BYTE_ORDER;
+        header.row_size = sizeof(Instruction);
+        header.clock = track.clk;
+        header.basetime = track.basetime;
+        header.speed = track.beginning.speed;
+        header.rows = track.rows;
+        header.frames = track.frames;
+        header.channels = track.channels;
+        header.instruments = track.instruments;
+        header.instruments_offset = sizeof(FileHeader);
+        header.effects_offset = header.instruments_offset + header.instruments * sizeof(FileInstrument);
+        header.order_offset = header.effects_offset + header.channels;
+        header.slots_offset = (header.order_offset + patterns + 1) / 2 * 2;
+        header.rows_offset = (header.slots_offset + patterns * sizeof(uint16_t) + CTK_ROWS_ALIGNMENT - 1) /
+                             CTK_ROWS_ALIGNMENT * CTK_ROWS_ALIGNMENT;
+        header.patterns = uint16_t(pool.size());
+        header.file_size = header.rows_offset + size_t(header.patterns) * track.rows * sizeof(Instruction);
+
+        std::vector<FileInstrument> instruments(track.instruments);
+        for (uint_fast8_t i = 0; i < track.instruments; ++i) {
+            const auto *psg = dynamic_cast<const PSG*>(track.instruments_bank[i]->get_oscillator());
+            if (psg == nullptr) {
+                const char *kind = dynamic_cast<const Wavetable*>(track.instruments_bank[i]->get_oscillator())
+                                   ? "a Wavetable" : "not a PSG";
+                fprintf(stderr, "C0deTracker : %s : instrument %u is %s, .ctk files only store PSG and "
+                                "BandLimitedPSG instruments\n", path, unsigned(i), kind);
+                return false;
+            }
+            FileInstrument &instrument = instruments[i];
+            instrument.oscillator = dynamic_cast<const BandLimitedPSG*>(psg) ? CTK_BAND_LIMITED_PSG : CTK_PSG;
+            instrument.wavetype = psg->getWavetype();
+            instrument.dutycycle = psg->getDutycycle();
+            instrument.phase = psg->getPhase();
+            instrument.attack = psg->getAmpEnvelope()->attack;
+            instrument.decay = psg->getAmpEnvelope()->decay;
+            instrument.sustain = psg->getAmpEnvelope()->sustain;
+            instrument.release = psg->getAmpEnvelope()->release;
+            instrument.curve = uint8_t(psg->getAmpEnvelope()->curve);
+            instrument.volume = track.instruments_bank[i]->getGlobalVolume();
+        }
+        std::vector<uint8_t> tables(header.rows_offset - header.effects_offset, 0);//effects, order, slots and padding
+        for (uint_fast8_t i = 0; i < track.channels; ++i) {
+            tables[i] = track.fx_per_chan[i];
+        }
+        for (size_t i = 0; i < patterns; ++i) {
+            tables[header.channels + i] = *track.pattern_indices[i];
+        }
+        std::memcpy(&tables[header.slots_offset - header.effects_offset], slots.data(), patterns * sizeof(uint16_t));
+
+        FILE *f = fopen(path, "wb");
+        if (f == nullptr) {
+            fprintf(stderr, "C0deTracker : %s : cannot create the file\n", path);
+            return false;
+        }
+        bool written = fwrite(&header, sizeof(FileHeader), 1, f) == 1 &&
+                       fwrite(instruments.data(), sizeof(FileInstrument), instruments.size(), f) == instruments.size() &&
+                       fwrite(tables.data(), 1, tables.size(), f) == tables.size();
+        for (uint_fast16_t i = 0; i < pool.size() && written; ++i) {
+            written = fwrite(pool.getRows(i), sizeof(Instruction), track.rows, f) == track.rows;
+        }
+        written = fclose(f) == 0 && written;
+        if (!written) {
+            fprintf(stderr, "C0deTracker : %s : cannot write the file\n", path);
+        }
+        return written;
+    }
+
+#if defined(_WIN32)
+    SongFile::SongFile(const char *path) {
+        HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            fprintf(stderr, "C0deTracker : %s : cannot open the file\n", path);
+            return;
+        }
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(handle, &file_size) && file_size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr) {
+                void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (view != nullptr) {
+                    this->data = static_cast<const uint8_t*>(view);
+                    this->size = size_t(file_size.QuadPart);
+                }
+                CloseHandle(mapping);//the view keeps the mapping alive
+            }
+        }
+        CloseHandle(handle);
+        if (this->data == nullptr) {
+            fprintf(stderr, "C0deTracker : %s : cannot map the file\n", path);
+        }
+    }
+
+    SongFile::~SongFile() {
+        if (this->data != nullptr) {
+            UnmapViewOfFile(this->data);
+        }
+    }
+#else
+    SongFile::SongFile(const char *path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "C0deTracker : %s : cannot open the file\n", path);
+            return;
+        }
+        struct stat status{};
+        if (fstat(fd, &status) == 0 && status.st_size > 0) {
+            void *view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                this->data = static_cast<const uint8_t*>(view);
+                this->size = size_t(status.st_size);
+            }
+        }
+        close(fd);//the mapping keeps the file alive
+        if (this->data == nullptr) {
+            fprintf(stderr, "C0deTracker : %s : cannot map the file\n", path);
+        }
+    }
+
+    SongFile::~SongFile() {
+        if (this->data != nullptr) {
+            munmap(const_cast<uint8_t*>(this->data), this->size);
+        }
+    }
+#endif
+}
@@ -2,6 +2,8 @@
 // Created by Abdulmajid, Olivier NASSER on 21/10/2020.
 //
 
+#include <algorithm>
+
 #include "../include/c0de_tracker.hpp"
 
 /**
@@ -20,7 +22,7 @@ namespace C0deTracker {
                  const uint_fast8_t *effects_per_chan) {
         this->clk = clk;
         this->basetime = basetime;
-        this->speed = speed;
+        this->state.speed = speed;
         this->rows = rows;
         this->frames = frames;
         this->channels = channels;
@@ -28,18 +30,221 @@ namespace C0deTracker {
         this->instruments = numb_of_instruments;
         this->track_patterns = track_patterns;
         this->pattern_indices = pattern_indices;
-        this->step = this->basetime * this->speed / this->clk;
-        this->duration = float(this->frames * this->rows) * this->step;
+        this->state.step = this->basetime * this->state.speed / this->clk;
+        this->state.duration = float(this->frames * this->rows) * this->state.step;
         this->fx_per_chan = effects_per_chan;
-        printf("STEP : %f\n", this->step);
-        printf("DURATION : %f\n", this->duration);
+        this->chan_buffer.resize(2 * this->channels * RENDER_BLOCK_SIZE);
+        this->active.resize(this->channels);
+        this->voices.resize(this->channels);
+        this->beginning = this->state;
+        if (Editor::arena != nullptr && Editor::arena->contains(track_patterns)) {
+            Arena *written = Editor::arena;
+            Editor::arena = nullptr;
+            this->sharePatterns(written);
+        }
+        if (this->track_patterns != nullptr) {
+            this->compileTimeline();
+        }
+        printf("STEP : %f\n", this->state.step);
+        printf("DURATION : %f\n", this->state.duration);
+    }
+
+    Track::Track(float clk, float basetime, float speed, uint_fast8_t rows, uint_fast8_t frames, uint_fast8_t channels,
+                 Instrument **instruments_bank, uint_fast8_t numb_of_instruments, const Instruction *song_rows,
+                 const uint16_t *slots, const uint_fast8_t *order, const uint_fast8_t *effects_per_chan)
+            : Track(clk, basetime, speed, rows, frames, channels, instruments_bank, numb_of_instruments,
+                    static_cast<Pattern**>(nullptr), static_cast<uint_fast8_t**>(nullptr), effects_per_chan) {
+        size_t patterns = size_t(channels) * frames;
+        size_t shared = 0;//patterns of song_rows
+        for (size_t i = 0; i < patterns; ++i) {
+            size_t used = slots != nullptr ? size_t(slots[i]) + 1 : i + 1;
+            shared = used > shared ? used : shared;
+        }
+        this->arena = new Arena(patterns * (sizeof(Pattern*) + sizeof(uint_fast8_t*)) + shared * sizeof(Pattern*) +
+                                shared * sizeof(Pattern) + 4 * alignof(std::max_align_t));
+        this->track_patterns = this->arena->createArray<Pattern*>(patterns);
+        this->pattern_indices = this->arena->createArray<uint_fast8_t*>(patterns);
+        auto **headers = this->arena->createArray<Pattern*>(shared);//one pattern for all the slots sharing its rows
+        //the track only reads the rows and the indices, so they can stay in read-only memory
+        auto *data_rows = const_cast<Instruction*>(song_rows);
+        auto *data_order = const_cast<uint_fast8_t*>(order);
+        for (size_t i = 0; i < patterns; ++i) {
+            size_t slot = slots != nullptr ? slots[i] : i;
+            if (headers[slot] == nullptr) {
+                headers[slot] = this->arena->create<Pattern>(rows, effects_per_chan[i / frames],
+                                                             data_rows + slot * rows);
+            }
+            this->track_patterns[i] = headers[slot];
+            this->pattern_indices[i] = &data_order[i];
+        }
+        this->compileTimeline();
+    }
+
+    Track::Track(const Track &song) {
+        this->clk = song.clk;
+        this->basetime = song.basetime;
+        this->rows = song.rows;
+        this->frames = song.frames;
+        this->channels = song.channels;
+        this->instruments_bank = song.instruments_bank;
+        this->instruments = song.instruments;
+        this->track_patterns = song.track_patterns;
+        this->pattern_indices = song.pattern_indices;
+        this->fx_per_chan = song.fx_per_chan;
+        this->timeline = song.timeline;
+        this->commands = song.commands;
+        this->spans = song.spans;
+        this->owns_song = false;
+        this->state = song.beginning;
+        this->beginning = song.beginning;
+        this->control_period = song.control_period;
+        this->chan_buffer.resize(2 * this->channels * RENDER_BLOCK_SIZE);
+        this->active.resize(this->channels);
+        this->voices.resize(this->channels);
+    }
+
+    void Track::sharePatterns(Arena *written) {
+        size_t patterns = size_t(this->channels) * this->frames;
+        PatternPool pool(this->rows);
+        std::vector<uint_fast16_t> slots(patterns, EMPTY_PATTERN);
+        std::vector<bool> played(patterns, false);
+        for (size_t i = 0; i < patterns; ++i) {
+            size_t slot = i - i % this->frames + *this->pattern_indices[i];
+            if (slot < patterns && !played[slot]) {
+                played[slot] = true;
+                slots[slot] = pool.add(this->track_patterns[slot]->instructions);
+            }
+        }
+
+        size_t pattern = sizeof(Pattern) + alignof(Pattern) + this->rows * sizeof(Instruction) + alignof(Instruction);
+        size_t tables = patterns * (sizeof(Pattern*) + sizeof(uint_fast8_t*) + sizeof(uint_fast8_t));
+        this->arena = new Arena(pool.size() * (pattern + sizeof(Pattern*)) + tables + 4 * alignof(std::max_align_t));
+        auto **shared = this->arena->createArray<Pattern*>(pool.size());
+        auto **track_patterns = this->arena->createArray<Pattern*>(patterns);
+        auto **pattern_indices = this->arena->createArray<uint_fast8_t*>(patterns);
+        auto *cells = this->arena->createArray<uint_fast8_t>(patterns);
+        for (size_t i = 0; i < patterns; ++i) {
+            uint_fast16_t p = slots[i];
+            if (shared[p] == nullptr) {
+                auto *rows = this->arena->createArray<Instruction>(this->rows);
+                std::copy(pool.getRows(p), pool.getRows(p) + this->rows, rows);
+                shared[p] = this->arena->create<Pattern>(this->rows, this->fx_per_chan[i / this->frames], rows);
+            }
+            track_patterns[i] = shared[p];
+            cells[i] = *this->pattern_indices[i];
+            pattern_indices[i] = &cells[i];
+        }
+        this->track_patterns = track_patterns;
+        this->pattern_indices = pattern_indices;
+        delete written;//the pool points to the rows of the Editor until here
+    }
+
+    void Track::compileTimeline() {
+        size_t patterns = size_t(this->channels) * this->frames;
+        this->timeline.clear();
+        this->commands.clear();
+        this->spans.assign(patterns, Span{0, 0});
+        for (uint_fast8_t c = 0; c < this->channels; ++c) {
+            if (this->fx_per_chan[c] > EFFECT_COLUMNS) {
+                fprintf(stderr, "C0deTracker : channel %u has %u effects per row, only the first %u are played\n",
+                        unsigned(c), unsigned(this->fx_per_chan[c]), unsigned(EFFECT_COLUMNS));
+            }
+        }
+        //slots sharing a pattern share its events, as long as their channels play the same number of effects
+        std::unordered_map<const Pattern*, Span> compiled[EFFECT_COLUMNS + 1];
+        for (size_t i = 0; i < patterns; ++i) {
+            Pattern *pat = this->track_patterns[i];
+            if (pat == nullptr) {
+                continue;
+            }
+            uint_fast8_t n_fx = std::min<uint_fast8_t>(this->fx_per_chan[i / this->frames], EFFECT_COLUMNS);
+            auto done = compiled[n_fx].find(pat);
+            if (done != compiled[n_fx].end()) {
+                this->spans[i] = done->second;
+                continue;
+            }
+            Span span{uint_fast32_t(this->timeline.size()), 0};
+            for (uint_fast8_t row = 0; row < this->rows; ++row) {
+                Instruction *instruction = &pat->instructions[row];
+                uint_fast8_t kinds = 0;
+                if (instruction->instrument_index < this->instruments) {
+                    kinds |= RowEvent::NOTE_ON;
+                } else if (instruction->instrument_index == Notes::RELEASE) {
+                    kinds |= RowEvent::NOTE_RELEASE;
+                } else if (instruction->instrument_index == Notes::CONTINUE && instruction->volume != Notes::CONTINUE &&
+                           0.f <= instruction->volume && instruction->volume <= MASTER_VOLUME) {
+                    kinds |= RowEvent::VOLUME_CHANGE;
+                }
+                auto first_effect = uint32_t(this->commands.size());
+                //effects are played from the last column to the first one
+                for (int_fast8_t fx_indx = int_fast8_t(n_fx) - 1; fx_indx >= 0; --fx_indx) {
+                    if (!instruction->hasEffect(fx_indx)) {
+                        continue;
+                    }
+                    EffectCommand fx{};
+                    uint_fast32_t code = instruction->effects[fx_indx];
+                    bool known = EffectCommand::decode(code, fx);
+                    if (fx.type == EffectCommand::JUMP &&
+                        (!known || fx.args[0] >= this->frames || fx.args[1] >= this->rows)) {
+                        fprintf(stderr, "C0deTracker : jump out of the song %08X in channel %u, pattern %u, row %u\n",
+                                unsigned(code), unsigned(i / this->frames), unsigned(i % this->frames), unsigned(row));
+                    } else if (!known) {
+                        fprintf(stderr, "C0deTracker : unknown effect %08X in channel %u, pattern %u, row %u\n",
+                                unsigned(code), unsigned(i / this->frames), unsigned(i % this->frames), unsigned(row));
+                    } else {
+                        this->commands.push_back(fx);
+                    }
+                }
+                auto effects = uint_fast8_t(this->commands.size() - first_effect);
+                if (effects != 0) {
+                    kinds |= RowEvent::EFFECTS;
+                }
+                if (kinds != 0) {
+                    this->timeline.push_back(RowEvent{row, kinds, effects, first_effect, instruction});
+                }
+            }
+            span.end = uint_fast32_t(this->timeline.size());
+            this->spans[i] = span;
+            compiled[n_fx].emplace(pat, span);
+        }
+    }
+
+    const RowEvent *Track::rowEvent(Channel &c) {
+        uint_fast8_t chan_number = c.getNumber();
+        uint_fast8_t pattern_index = *this->pattern_indices[chan_number * this->frames + this->state.frame_counter];
+        const Span &span = this->spans[chan_number * this->frames + pattern_index];
+        uint_fast8_t row = this->state.row_counter;
+        //rows are usually read one after the other, the next event of the channel is then the one of this row or a
+        //later one. After a jump, a new pattern or a seek, the event is searched again.
+        uint_fast32_t i = c.next_event;
+        if (i < span.begin || i > span.end || (i > span.begin && this->timeline[i - 1].row >= row) ||
+            (i < span.end && this->timeline[i].row < row)) {
+            i = uint_fast32_t(std::lower_bound(this->timeline.begin() + span.begin, this->timeline.begin() + span.end,
+                                               row, [](const RowEvent &e, uint_fast8_t r) { return e.row < r; }) -
+                              this->timeline.begin());
+        }
+        if (i == span.end || this->timeline[i].row != row) {
+            c.next_event = i;
+            return nullptr;
+        }
+        c.next_event = i + 1;
+        return &this->timeline[i];
     }
 
     Track::~Track() {
-        for (uint8_t i = 0; i < this->channels * this->frames; ++i) { delete this->pattern_indices[i]; }
-        delete[] this->pattern_indices;
-        for (uint8_t i = 0; i < this->channels * this->frames; ++i) {delete this->track_patterns[i];}
-        delete[] this->track_patterns;
+        delete this->pool;
+        if (!this->owns_song) {
+            return;
+        }
+        if (this->arena != nullptr) {
+            delete this->arena;//patterns, rows and indices are all in the arena
+            delete this->file;//or in the file for loaded tracks
+        } else {
+            for (uint_fast16_t i = 0; i < this->channels * this->frames; ++i) { delete this->pattern_indices[i]; }
+            delete[] this->pattern_indices;
+            for (uint_fast16_t i = 0; i < this->channels * this->frames; ++i) {delete this->track_patterns[i];}
+            delete[] this->track_patterns;
+        }
         for (uint8_t i = 0; i < this->instruments; ++i) { delete this->instruments_bank[i]; }
         delete[] this->instruments_bank;
     }
@@ -50,309 +255,764 @@ namespace C0deTracker {
     }
 
     float Track::getDuration() {
-        return this->duration;
+        return this->state.duration;
     }
 
     void Track::update_fx(double t) {
-        this->volume -= (this->volume_slide_down / this->speed) * (t - this->volume_slide_time);
-        if (this->volume <= 0) {
-            this->volume = 0.f;
-            this->volume_slide_down = 0.f;
-        }
-        this->volume += (this->volume_slide_up / this->speed) * (t - this->volume_slide_time);
-        if (this->volume >= MASTER_VOLUME) {
-            this->volume = MASTER_VOLUME;
-            this->volume_slide_up = 0.f;
-        }
-
-        this->pitch -= (this->pitch_slide_down / this->speed) * (t - this->pitch_slide_time);
+        this->modulate(t, 1, 0.);
+    }
 
-        this->pitch += (this->pitch_slide_up / this->speed) * (t - this->pitch_slide_time);
+    void Track::modulate(double t, uint_fast32_t samples, double dt) {
+        if (this->state.volume_slide_down != 0.f || this->state.volume_slide_up != 0.f) {
+            double elapsed = slideTime(t, this->state.volume_slide_time, samples, dt);
+            this->state.volume -= (this->state.volume_slide_down / this->state.speed) * elapsed;
+            if (this->state.volume <= 0) {
+                this->state.volume = 0.f;
+                this->state.volume_slide_down = 0.f;
+            }
+            this->state.volume += (this->state.volume_slide_up / this->state.speed) * elapsed;
+            if (this->state.volume >= MASTER_VOLUME) {
+                this->state.volume = MASTER_VOLUME;
+                this->state.volume_slide_up = 0.f;
+            }
+        }
 
-        this->panning += (this->panning_slide_right / this->speed) * (t - this->panning_slide_time);
-        if (this->panning >= MASTER_VOLUME) {
-            this->panning = MASTER_VOLUME;
-            this->panning_slide_right = 0.f;
+        if (this->state.pitch_slide_down != 0.f || this->state.pitch_slide_up != 0.f) {
+            double elapsed = slideTime(t, this->state.pitch_slide_time, samples, dt);
+            this->state.pitch -= (this->state.pitch_slide_down / this->state.speed) * elapsed;
+            this->state.pitch += (this->state.pitch_slide_up / this->state.speed) * elapsed;
         }
-        this->panning -= (this->panning_slide_left / this->speed) * (t - this->panning_slide_time);
-        if (this->panning <= 0) {
-            this->panning = 0;
-            this->panning_slide_left = 0.f;
+
+        if (this->state.panning_slide_right != 0.f || this->state.panning_slide_left != 0.f) {
+            double elapsed = slideTime(t, this->state.panning_slide_time, samples, dt);
+            this->state.panning += (this->state.panning_slide_right / this->state.speed) * elapsed;
+            if (this->state.panning >= MASTER_VOLUME) {
+                this->state.panning = MASTER_VOLUME;
+                this->state.panning_slide_right = 0.f;
+            }
+            this->state.panning -= (this->state.panning_slide_left / this->state.speed) * elapsed;
+            if (this->state.panning <= 0) {
+                this->state.panning = 0;
+                this->state.panning_slide_left = 0.f;
+            }
         }
 
-        if (this->tremolo_speed == 0.f || this->tremolo_depth == 0.f) {
-            this->tremolo_val = 1.0f;
+        if (this->state.tremolo_speed == 0.f || this->state.tremolo_depth == 0.f) {
+            this->state.tremolo_val = 1.0f;
         } else {
-            this->tremolo_val =
-                    0.5f * this->tremolo_depth * sin(TWOPI * this->tremolo_speed * (t - this->tremolo_time)) +
-                    (1 - 0.5f * this->tremolo_depth);
+            this->state.tremolo_val =
+                    0.5f * this->state.tremolo_depth * sin(TWOPI * this->state.tremolo_speed * (t - this->state.tremolo_time)) +
+                    (1 - 0.5f * this->state.tremolo_depth);
         }
-        if (this->vibrato_speed == 0.f || this->vibrato_depth == 0.f) {
-            this->vibrato_val = 0.0f;
+        if (this->state.vibrato_speed == 0.f || this->state.vibrato_depth == 0.f) {
+            this->state.vibrato_val = 0.0f;
         } else {
-            this->vibrato_val = this->vibrato_depth * sin(TWOPI * this->vibrato_speed * (t - this->vibrato_time));
-        }
-        //printf("volume %f", this->volume);
-    }
-
-    bool Track::decode_fx(uint_fast32_t fx, double t) {
-        uint_fast8_t fx_code = fx >> 4 * 6;
-        uint_fast32_t fx_val = fx & 0x00FFFFFF;
-        //printf("%.3f FX CODE : %x ; FX VAL : %x\n", t, fx_code, fx_val);
-        switch (fx_code) {
-            case 0x00://pitch slide up
-                this->pitch_slide_up = float(fx_val) / float(0x00FFFFFF);
-                this->pitch_slide_down = 0.f;
-                this->pitch_slide_time = t;
-
-                return true;
-            case 0x01://pitch slide down
-                this->pitch_slide_down = float(fx_val) / float(0x00FFFFFF);
-                this->pitch_slide_up = 0.f;
-                this->pitch_slide_time = t;
-                return true;
-            case 0x02://vibrato
-                this->vibrato_speed = float((fx_val >> 4 * 3)) / float(0x100);
-                this->vibrato_depth = float(fx_val & 0xFFF) / float(0x800);
-                this->vibrato_time = t;
-                return true;
-            case 0x03://set pitch
-                this->pitch = (float(fx_val) - float(0x800000)) / float(0x800000);
-                return true;
-            case 0x04://set volume
-                this->volume = float(fx_val) / float(0x00FFFFFF);
-                return true;
-            case 0x05://volume slide up
-                this->volume_slide_up = float(fx_val) / float(0x00FFFFFF);
-                this->volume_slide_down = 0.f;
-                this->volume_slide_time = t;
-                return true;
-            case 0x06://volume slide down
-                this->volume_slide_down = float(fx_val) / float(0x00FFFFFF);
-                this->volume_slide_up = 0.f;
-                this->volume_slide_time = t;
-                return true;
-            case 0x07://tremolo
-                this->tremolo_speed = float(fx_val >> 4 * 3) / float(0x100);
-                this->tremolo_depth = float(fx_val & 0xFFF) / float(0xFFF);
-                this->tremolo_time = t; //printf("tremolo speed %f\n", this->tremolo_speed);
-                return true;
-            case 0x08://set global track panning
-                this->panning = float(fx_val) / float(0xFFFFFF);
-                return true;
-            case 0x09://change speed of the track
-                this->speed = float(fx_val >> 4 * 3) + float(fx_val & 0xFFF) / float(0xFFF);;
-                this->step = this->basetime * this->speed / this->clk;
-                this->duration = float(this->frames * this->rows) * this->step;
-                return true;
-            case 0x0A:// jumpt to frame row
-                this->branch = true;
-                this->frametojump = fx_val >> 4 * 3;
-                this->rowtojump = fx_val & 0xFFF;
-                if ((this->frametojump == this->frame_counter && this->rowtojump == this->row_counter) ||
-                    (this->frametojump >= this->frames) || (this->rowtojump >= this->rows)) {
-                    this->branch = false;
+            this->state.vibrato_val = this->state.vibrato_depth * sin(TWOPI * this->state.vibrato_speed * (t - this->state.vibrato_time));
+        }
+    }
+
+    void Track::setControlPeriod(uint_fast32_t samples) {
+        this->control_period = samples;
+    }
+
+    uint_fast32_t Track::getControlPeriod() {
+        return this->control_period;
+    }
+
+    void Track::setRenderThreads(unsigned threads) {
+        delete this->pool;
+        this->pool = (threads > 1) ? new WorkerPool(threads) : nullptr;
+    }
+
+    unsigned Track::getRenderThreads() {
+        return (this->pool != nullptr) ? this->pool->getThreads() : 1;
+    }
+
+    void Track::applyEffect(const EffectCommand &fx, double t) {
+        switch (fx.type) {
+            case EffectCommand::TRACK_PITCH_SLIDE_UP:
+                this->state.pitch_slide_up = fx.x;
+                this->state.pitch_slide_down = 0.f;
+                this->state.pitch_slide_time = t;
+                break;
+            case EffectCommand::TRACK_PITCH_SLIDE_DOWN:
+                this->state.pitch_slide_down = fx.x;
+                this->state.pitch_slide_up = 0.f;
+                this->state.pitch_slide_time = t;
+                break;
+            case EffectCommand::TRACK_VIBRATO:
+                this->state.vibrato_speed = fx.x;
+                this->state.vibrato_depth = fx.y;
+                this->state.vibrato_time = t;
+                break;
+            case EffectCommand::TRACK_PITCH:
+                this->state.pitch = fx.x;
+                break;
+            case EffectCommand::TRACK_VOLUME:
+                this->state.volume = fx.x;
+                break;
+            case EffectCommand::TRACK_VOLUME_SLIDE_UP:
+                this->state.volume_slide_up = fx.x;
+                this->state.volume_slide_down = 0.f;
+                this->state.volume_slide_time = t;
+                break;
+            case EffectCommand::TRACK_VOLUME_SLIDE_DOWN:
+                this->state.volume_slide_down = fx.x;
+                this->state.volume_slide_up = 0.f;
+                this->state.volume_slide_time = t;
+                break;
+            case EffectCommand::TRACK_TREMOLO:
+                this->state.tremolo_speed = fx.x;
+                this->state.tremolo_depth = fx.y;
+                this->state.tremolo_time = t;
+                break;
+            case EffectCommand::TRACK_PANNING:
+                this->state.panning = fx.x;
+                break;
+            case EffectCommand::TRACK_SPEED:
+                this->state.speed = fx.x;
+                this->state.step = this->basetime * this->state.speed / this->clk;
+                this->state.duration = float(this->frames * this->rows) * this->state.step;
+                break;
+            case EffectCommand::JUMP://the jumps out of the song are left out of the timeline
+                this->state.branch = true;
+                this->state.frametojump = fx.args[0];
+                this->state.rowtojump = fx.args[1];
+                if (this->state.frametojump == this->state.frame_counter && this->state.rowtojump == this->state.row_counter) {
+                    this->state.branch = false;
                 }
-                return true;
-            case 0x0B://stop song
-                this->stop = true;
-                return true;
-            case 0x0D://slide right panning
-                this->panning_slide_right = float(fx_val) / float(0xFFFFFF);
-                this->panning_slide_left = 0.0f;
-                this->panning_slide_time = t;
-                return true;
-            case 0x0E://slide left panning
-                this->panning_slide_left = float(fx_val) / float(0xFFFFFF);
-                this->panning_slide_right = 0.0f;
-                this->panning_slide_time = t;
-                return true;
+                break;
+            case EffectCommand::STOP:
+                this->state.stop = true;
+                break;
+            case EffectCommand::TRACK_PANNING_SLIDE_RIGHT:
+                this->state.panning_slide_right = fx.x;
+                this->state.panning_slide_left = 0.0f;
+                this->state.panning_slide_time = t;
+                break;
+            case EffectCommand::TRACK_PANNING_SLIDE_LEFT:
+                this->state.panning_slide_left = fx.x;
+                this->state.panning_slide_right = 0.0f;
+                this->state.panning_slide_time = t;
+                break;
             default:
-                //printf("unknown effect %x\n", fx_code);
-                return false;
+                break;
         }
     }
 
     float *Track::play(double t, Channel *chan, uint_fast8_t size_of_chans) {
         static float res[2];
+        this->render(res, 1, t, 1.0, chan, size_of_chans);
+        return res;
+    }
 
-        res[0] = 0.f; res[1] = 0.f;
-        this->update_fx(t);
-
-        if (t - this->time_advance >= this->step) {
-            if (this->stop) {
-                res[0] = 0;
-                res[1] = 0;
-                return res;
-            }
-            this->time_advance += this->step;
-            ++this->row_counter;
-            this->readFx = true;
-            if (this->branch) {
-                this->row_counter = this->rowtojump;
-                this->frame_counter = this->frametojump;
-                this->branch = false;
-            }
-        }
-
-        if (this->row_counter >= this->rows) {
-            this->row_counter = 0;
-            ++this->frame_counter;
-        }
-        if (this->frame_counter >= this->frames) {
-            this->frame_counter = 0;
-        }
+    void Track::render(float *out, size_t frames, double t, double sample_rate, Channel *chan,
+                       uint_fast8_t size_of_chans, bool planar) {
+        this->renderFrom(out, frames, t, 0, sample_rate, chan, size_of_chans, planar);
+    }
 
-        float s = 0.f;//generated signal
-        float a = 0.f;//amplitude
-        float p = 0.f;//pitch
+    void Track::renderFrom(float *out, size_t frames, double t, size_t first, double sample_rate, Channel *chan,
+                           uint_fast8_t size_of_chans, bool planar) {
         uint_fast8_t n_of_chans = 0;
         if(size_of_chans < this->getNumberofChannels()){
             n_of_chans = size_of_chans;
-
         } else{
             n_of_chans = this->getNumberofChannels();
         }
+
+        size_t done = 0;
+        while (done < frames) {
+            size_t len = this->renderSegment(out, frames, done, t, first, sample_rate, chan, n_of_chans, planar);
+            if (len == 0) {//song stopped, the rest of the block is silent
+                for (size_t k = done; k < frames && !this->dry; ++k) {
+                    if (planar) { out[k] = 0.f; out[frames + k] = 0.f; }
+                    else { out[2 * k] = 0.f; out[2 * k + 1] = 0.f; }
+                }
+                break;
+            }
+            done += len;
+        }
+    }
+
+    size_t Track::renderSegment(float *out, size_t frames, size_t done, double t, size_t first, double sample_rate,
+                                Channel *chan, uint_fast8_t n_of_chans, bool planar) {
+        //sample n of the block is rendered at t + (first + n) / sample_rate
+        size_t at = first + done;
+        double t0 = t + double(at) / sample_rate;
+        if (this->checkpoint_rows != 0 && t0 - this->state.time_advance >= this->state.step) {//a row starts
+            this->recordCheckpoint(t0, sample_rate, chan, n_of_chans);
+        }
+        this->update_fx(t0);
+        if (!this->advance(t0)) {
+            return 0;
+        }
+        //first sample of the segment : rows are read channel by channel, exactly as the sequencer always did
         for (int_fast8_t i = n_of_chans - 1; i >= 0; --i) {
+            this->active[i] = false;
             if (chan[i].isEnable()) {
-                if(chan[i].getTrack() != nullptr){
-                    chan[i].update_fx(t);
+                if (chan[i].getTrack() != nullptr) {
+                    chan[i].update_fx(t0);
                 }
-                uint_fast8_t chan_number = chan[i].getNumber();
-                uint_fast8_t pattern_index = *this->pattern_indices[chan_number * this->frames + this->frame_counter];
-                Pattern *pat = this->track_patterns[chan_number * (this->frames) + pattern_index];
-                Instruction *current_instruction = pat->instructions[this->row_counter];
-
-
-                if (current_instruction->instrument_index < this->instruments) {
-                    if (this->readFx) {
-                        chan[i].setLastInstructionAddress(current_instruction);
-                        chan[i].setRelease(false);
-                        chan[i].setTime(t);
-                        chan[i].setTrack(this);
-                        if(chan[i].getInstructionState()->key.note == Notes::CONTINUE || chan[i].getInstructionState()->key.octave == Notes::CONTINUE){
-                            if(chan[i].getInstructionState()->instrument_index != current_instruction->instrument_index){
-                                delete chan[i].instrument;
-                                chan[i].instrument = this->instruments_bank[current_instruction->instrument_index]->clone();
-                            }
-                            chan[i].setInstructionState(current_instruction);
-                        }else{
-                            if(!chan[i].portamento){
-                                if(chan[i].getInstructionState()->instrument_index != current_instruction->instrument_index){
-                                    delete chan[i].instrument;
-                                    chan[i].instrument = this->instruments_bank[current_instruction->instrument_index]->clone();
-                                }
-                                chan[i].setInstructionState(current_instruction);
-                            }else{
-                                chan[i].portamento_time_step = t;
-                                if(chan[i].instruct_state.key.octave == Notes::CONTINUE){
-                                    chan[i].porta_pitch_dif = 0;
-                                }else{
-                                    chan[i].porta_pitch_dif += Notes::key2pitch(current_instruction->key) - (Notes::key2pitch(chan[i].instruct_state.key) /*- chan[i].porta_pitch_dif*/);
-                                }
-
-                                if(chan[i].getInstructionState()->instrument_index != current_instruction->instrument_index){
-                                    delete chan[i].instrument;
-                                    chan[i].instrument = this->instruments_bank[current_instruction->instrument_index]->clone();
-                                }
-                                chan[i].setInstructionState(current_instruction);
-                            }
-                        }
-                        chan[i].instrument->get_oscillator()->setRelease(false);
-                        chan[i].pitch_slide_val = 0;
-                        chan[i].pitch_slide_time = t;
-                        chan[i].transpose_time_step = t;
-                        chan[i].transpose_semitone_counter = 0;
-                        chan[i].retrieg_time_step = t;
-                        chan[i].retrieg_counter = 0;
-                        chan[i].delrel_time_step = t;
-                        chan[i].release_counter = 0;
-                        chan[i].delay_counter = 0;
-                        if(chan[i].n_time_to_transpose > 0){
-                            --chan[i].n_time_to_transpose;
-                        }
-                        if(chan[i].n_time_to_retrieg > 0){
-                            --chan[i].n_time_to_retrieg;
-                        }
-                        if(chan[i].n_time_to_delrel){
-                            --chan[i].n_time_to_delrel;
-                        }
-                    }
-                } else {
-                    if (chan[i].getLastInstructionAddress() != nullptr) {
-                        if (current_instruction->instrument_index == Notes::RELEASE &&
-                            chan[i].getInstructionState()->instrument_index < this->instruments) {
-                            if (!chan[i].isReleased()) {
-                                chan[i].setRelease(true);
-                                chan[i].setTimeRelease(t);
-                                chan[i].setTrack(this);
-                                chan[i].instrument->get_oscillator()->setRelease(true);
-                            }
-                            if (current_instruction->volume != Notes::CONTINUE &&
-                                ((0.f <= current_instruction->volume) &&
-                                 (current_instruction->volume <= MASTER_VOLUME))) {
-                                chan[i].setVolumeInstructionState(current_instruction->volume);
-                            }
-                        }
-                        if (current_instruction->instrument_index == Notes::CONTINUE &&
-                            chan[i].getInstructionState()->instrument_index < this->instruments) {
-                            if (current_instruction->volume != Notes::CONTINUE &&
-                                ((0.f <= current_instruction->volume) &&
-                                 (current_instruction->volume <= MASTER_VOLUME))) {
-                                chan[i].setVolumeInstructionState(current_instruction->volume);
-                            }
-                        }
-                    }
+                if (this->state.readFx) {
+                    this->readRow(chan[i], t0);
                 }
+                float s = this->playChannel(chan[i], t0, this->state.pitch + this->state.vibrato_val);
+                if (chan[i].getLastInstructionAddress() != nullptr && chan[i].getTrack() != nullptr) {
+                    this->active[i] = true;
+                    this->chan_buffer[(2 * i) * RENDER_BLOCK_SIZE] = s * (1 - chan[i].panning);
+                    this->chan_buffer[(2 * i + 1) * RENDER_BLOCK_SIZE] = s * chan[i].panning;
+                }
+            }
+        }
+        this->state.readFx = false;
+        this->frame_pitch[0] = this->state.pitch + this->state.vibrato_val;
+        this->frame_gain[0] = this->state.volume * this->state.tremolo_val; this->frame_panning[0] = this->state.panning;
 
-                if (current_instruction->effects != nullptr && this->readFx) {
-                    for (int_fast8_t fx_indx = this->fx_per_chan[chan_number] - 1; fx_indx >= 0; --fx_indx) {
-                        if (current_instruction->effects[fx_indx] != nullptr) {
-                            if (!this->decode_fx(*current_instruction->effects[fx_indx], t)) {
-                                chan[i].decode_fx(*current_instruction->effects[fx_indx], t);
-                            }
-                        }
-                    }
+        //the segment lasts until the next row or the end of the block
+        size_t len = 1;
+        while (len < RENDER_BLOCK_SIZE && done + len < frames &&
+               (t + double(at + len) / sample_rate) - this->state.time_advance < this->state.step) {
+            ++len;
+        }
+
+        //effects are evaluated at control points (every control period and at the end of the segment) and
+        //linearly interpolated in between
+        size_t period = this->control_period;
+        if (period == 0) {//once per tick
+            period = size_t(sample_rate / this->clk + 0.5);
+        }
+        if (period == 0) {
+            period = 1;
+        }
+        double dt = 1. / sample_rate;
+        for (size_t prev = 0; prev + 1 < len;) {
+            size_t end = (prev + period < len - 1) ? prev + period : len - 1;
+            this->modulate(t + double(at + end) / sample_rate, end - prev, dt);
+            this->frame_pitch[end] = this->state.pitch + this->state.vibrato_val;
+            this->frame_gain[end] = this->state.volume * this->state.tremolo_val; this->frame_panning[end] = this->state.panning;
+            for (size_t k = prev + 1; k < end; ++k) {
+                float w = float(k - prev) / float(end - prev);
+                this->frame_pitch[k] = this->frame_pitch[prev] + (this->frame_pitch[end] - this->frame_pitch[prev]) * w;
+                this->frame_gain[k] = this->frame_gain[prev] + (this->frame_gain[end] - this->frame_gain[prev]) * w;
+                this->frame_panning[k] = this->frame_panning[prev] + (this->frame_panning[end] - this->frame_panning[prev]) * w;
+            }
+            prev = end;
+        }
+
+        //the channels only read the track from now on, they can be rendered at the same time
+        if (this->pool != nullptr && n_of_chans > 1 && len > 1) {
+            Segment segment{this, chan, at, len, period, t, sample_rate};
+            this->pool->run(n_of_chans, Track::renderChannelJob, &segment);
+        } else {
+            for (int_fast8_t i = n_of_chans - 1; i >= 0; --i) {
+                this->renderChannel(chan[i], i, at, len, t, sample_rate, period);
+            }
+        }
+
+        bool audible = false;
+        for (uint_fast8_t i = 0; i < n_of_chans; ++i) {
+            audible = audible || this->voices[i].audible;
+        }
+        if (!audible) {//every channel is silent, so is the segment
+            for (size_t k = 0; k < len && !this->dry; ++k) {
+                if (planar) { out[done + k] = 0.f; out[frames + done + k] = 0.f; }
+                else { out[2 * (done + k)] = 0.f; out[2 * (done + k) + 1] = 0.f; }
+            }
+        }
+        for (size_t k = 0; k < len && !this->dry && audible; ++k) {
+            float l = 0.f, r = 0.f;
+            for (int_fast8_t i = n_of_chans - 1; i >= 0; --i) {
+                if (this->voices[i].audible) {
+                    l += this->chan_buffer[(2 * i) * RENDER_BLOCK_SIZE + k];
+                    r += this->chan_buffer[(2 * i + 1) * RENDER_BLOCK_SIZE + k];
+                }
+            }
+            l *= this->frame_gain[k];
+            r *= this->frame_gain[k];
+            l *= 4*(1 - this->frame_panning[k]);//left
+            r *= 4*this->frame_panning[k];//right
+            if (planar) { out[done + k] = l; out[frames + done + k] = r; }
+            else { out[2 * (done + k)] = l; out[2 * (done + k) + 1] = r; }
+        }
+
+        this->state.time = t + double(at + len - 1) / sample_rate;
+        return len;
+    }
+
+    namespace {
+        struct ExportPart {//a part of the song rendered by one job, starting at the beginning of a row
+            size_t first;
+            Track::State state;
+            std::vector<Channel> channels;
+        };
+
+        struct Exporter {
+            Track *song;
+            float *out;
+            size_t frames;
+            double sample_rate;
+            std::vector<ExportPart> parts;
+            std::mutex mutex;
+            std::condition_variable ready;
+            size_t captured = 0;//parts whose start is known
+        };
+    }
+
+    void Track::exportSong(float *out, size_t frames, double sample_rate, unsigned threads) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        Exporter exporter;
+        exporter.song = this;
+        exporter.out = out;
+        exporter.frames = frames;
+        exporter.sample_rate = sample_rate;
+        //several parts per thread to even out the dense passages
+        exporter.parts.resize((threads > 1) ? 4 * threads : 1);
+
+        //job 0 is the sequencer running ahead, the other ones render the parts as soon as their start is known
+        WorkerPool pool(threads);
+        pool.run(exporter.parts.size() + 1, Track::exportJob, &exporter);
+    }
+
+    bool Track::rowStarts(size_t at, size_t target, double sample_rate) const {
+        return at >= target && (at == 0 || double(at) / sample_rate - this->state.time_advance >= this->state.step);
+    }
+
+    void Track::exportJob(void *exporter, size_t i) {
+        Exporter *e = static_cast<Exporter *>(exporter);
+        size_t n_parts = e->parts.size();
+        if (i == 0) {//the sequencer copies itself at the first row starting after the beginning of each part
+            Track sequencer(*e->song);
+            sequencer.dry = true;
+            std::vector<Channel> chan;
+            chan.reserve(sequencer.channels);
+            for (uint_fast8_t c = 0; c < sequencer.channels; ++c) {
+                chan.emplace_back(c);
+            }
+            size_t pos = 0;
+            bool stopped = false;
+            for (size_t j = 0; j < n_parts; ++j) {
+                size_t target = e->frames * j / n_parts;
+                while (!stopped && pos < e->frames && !sequencer.rowStarts(pos, target, e->sample_rate)) {
+                    size_t len = sequencer.renderSegment(nullptr, e->frames, pos, 0., 0, e->sample_rate, chan.data(),
+                                                         sequencer.channels, false);
+                    stopped = (len == 0);
+                    pos += len;
                 }
-                //check if channel is released because of release effect
-                if(chan[i].isReleased()){
-                    chan[i].instrument->get_oscillator()->setRelease(true);
+                ExportPart &part = e->parts[j];
+                part.first = (stopped) ? e->frames : pos;//the part playing when the song stops renders the silence
+                part.state = sequencer.state;
+                part.channels.reserve(sequencer.channels);
+                for (uint_fast8_t c = 0; c < sequencer.channels; ++c) {
+                    part.channels.emplace_back(c);
+                    part.channels[c].restore(chan[c]);
                 }
+                {
+                    std::lock_guard<std::mutex> lock(e->mutex);
+                    ++e->captured;
+                }
+                e->ready.notify_all();
+            }
+            return;
+        }
 
-                uint_fast8_t arpeggio = 0;
-                if(chan[i].arpeggio){
-                    arpeggio = chan[i].arpeggio_val[chan[i].arpeggio_index];
+        size_t j = i - 1;
+        {
+            std::unique_lock<std::mutex> lock(e->mutex);
+            e->ready.wait(lock, [e, j] { return e->captured > j; });
+        }
+        ExportPart &part = e->parts[j];
+        Track track(*e->song);
+        track.state = part.state;
+        for (Channel &c : part.channels) {
+            if (c.getTrack() != nullptr) {
+                c.setTrack(&track);
+            }
+        }
+        //the part ends where the sequencer starts the next one
+        size_t target = (j + 1 < n_parts) ? e->frames * (j + 1) / n_parts : e->frames;
+        size_t pos = part.first;
+        while (pos < e->frames && !track.rowStarts(pos, target, e->sample_rate)) {
+            size_t len = track.renderSegment(e->out, e->frames, pos, 0., 0, e->sample_rate, part.channels.data(),
+                                             track.channels, false);
+            if (len == 0) {//song stopped, the rest of the song is silent
+                for (size_t k = pos; k < e->frames; ++k) {
+                    e->out[2 * k] = 0.f;
+                    e->out[2 * k + 1] = 0.f;
                 }
+                break;
+            }
+            pos += len;
+        }
+    }
 
-                a =  chan[i].getVolume() * chan[i].tremolo_val * chan[i].getInstructionState()->volume;
-                p = Notes::key2pitch(chan[i].getInstructionState()->key) + this->pitch + this->vibrato_val + chan[i].pitch + chan[i].pitch_slide_val + chan[i].vibrato_val + arpeggio - chan[i].porta_pitch_dif;
+    void Track::setCheckpointInterval(uint_fast32_t rows) {
+        this->checkpoint_rows = rows;
+        this->rows_since_checkpoint = 0;
+    }
 
-                if (chan[i].getLastInstructionAddress() != nullptr && chan[i].getTrack() != nullptr) {
-                    if (!chan[i].isReleased()) {
-                        s = chan[i].instrument->play_pitch(a, p, t - chan[i].getTime());
-                    } else {
-                        s = chan[i].instrument->play_pitch(a, p, t - chan[i].getTime(), t - chan[i].getTimeRelease());
+    uint_fast32_t Track::getCheckpointInterval() {
+        return this->checkpoint_rows;
+    }
+
+    void Track::recordCheckpoint(double t, double sample_rate, Channel *chan, uint_fast8_t n_of_chans) {
+        if (sample_rate != this->checkpoint_rate) {//the checkpoints replay the song at their own sample rate
+            this->checkpoints.clear();
+            this->checkpoint_rate = sample_rate;
+        }
+        if (++this->rows_since_checkpoint < this->checkpoint_rows ||
+            (!this->checkpoints.empty() && t <= this->checkpoints.back().time)) {
+            return;
+        }
+        this->rows_since_checkpoint = 0;
+        this->checkpoints.emplace_back();
+        Checkpoint &checkpoint = this->checkpoints.back();
+        checkpoint.time = t;
+        checkpoint.state = this->state;
+        checkpoint.channels.reserve(n_of_chans);
+        for (uint_fast8_t i = 0; i < n_of_chans; ++i) {
+            checkpoint.channels.emplace_back(chan[i].getNumber());
+            checkpoint.channels[i].restore(chan[i]);
+        }
+    }
+
+    void Track::buildCheckpoints(double seconds, double sample_rate) {
+        if (this->checkpoint_rows == 0) {
+            this->checkpoint_rows = CHECKPOINT_ROWS;
+        }
+        Track sequencer(*this);
+        sequencer.dry = true;
+        sequencer.checkpoint_rows = this->checkpoint_rows;
+        std::vector<Channel> chan;
+        chan.reserve(this->channels);
+        for (uint_fast8_t i = 0; i < this->channels; ++i) {
+            chan.emplace_back(i);
+        }
+        sequencer.renderFrom(nullptr, size_t(seconds * sample_rate), 0., 0, sample_rate, chan.data(), this->channels,
+                             false);
+        this->checkpoints.swap(sequencer.checkpoints);
+        this->checkpoint_rate = sample_rate;
+    }
+
+    void Track::seek(double t, double sample_rate, Channel *chan, uint_fast8_t size_of_chans) {
+        uint_fast8_t n_of_chans = (size_of_chans < this->channels) ? size_of_chans : this->channels;
+        double start = 0.;
+        const Checkpoint *from = nullptr;
+        if (sample_rate == this->checkpoint_rate) {//last checkpoint before t
+            size_t lo = 0, hi = this->checkpoints.size();
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (this->checkpoints[mid].time <= t) { lo = mid + 1; } else { hi = mid; }
+            }
+            if (lo > 0) {
+                from = &this->checkpoints[lo - 1];
+            }
+        }
+        if (from != nullptr) {
+            start = from->time;
+            this->state = from->state;
+            for (uint_fast8_t i = 0; i < n_of_chans && i < from->channels.size(); ++i) {
+                chan[i].restore(from->channels[i]);
+            }
+        } else {
+            this->state = this->beginning;
+            for (uint_fast8_t i = 0; i < n_of_chans; ++i) {
+                Channel beginning(chan[i].getNumber());
+                chan[i].restore(beginning);
+            }
+        }
+        for (uint_fast8_t i = 0; i < n_of_chans; ++i) {
+            if (chan[i].getTrack() != nullptr) {
+                chan[i].setTrack(this);
+            }
+        }
+        this->rows_since_checkpoint = 0;
+
+        //the rows between the checkpoint and t are played without sound
+        this->dry = true;
+        this->renderFrom(nullptr, size_t((t - start) * sample_rate + 0.5), start, 0, sample_rate, chan, n_of_chans,
+                         false);
+        this->dry = false;
+    }
+
+    const Track::State &Track::getState() const {
+        return this->state;
+    }
+
+    void Track::setState(const Track::State &state) {
+        this->state = state;
+    }
+
+    bool Track::advance(double t) {
+        if (t - this->state.time_advance >= this->state.step) {
+            if (this->state.stop) {
+                return false;
+            }
+            this->state.time_advance += this->state.step;
+            ++this->state.row_counter;
+            this->state.readFx = true;
+            if (this->state.branch) {
+                this->state.row_counter = this->state.rowtojump;
+                this->state.frame_counter = this->state.frametojump;
+                this->state.branch = false;
+            }
+        }
+
+        if (this->state.row_counter >= this->rows) {
+            this->state.row_counter = 0;
+            ++this->state.frame_counter;
+        }
+        if (this->state.frame_counter >= this->frames) {
+            this->state.frame_counter = 0;
+        }
+        return true;
+    }
+
+    void Track::readRow(Channel &c, double t) {
+        const RowEvent *event = this->rowEvent(c);
+        if (event == nullptr) {//empty row, nothing changes
+            return;
+        }
+        Instruction *current_instruction = event->instruction;
+
+        if (event->kinds & RowEvent::NOTE_ON) {
+            c.setLastInstructionAddress(current_instruction);
+            c.setRelease(false);
+            c.setTime(t);
+            c.setTrack(this);
+            if(c.getInstructionState()->key.note == Notes::CONTINUE || c.getInstructionState()->key.octave == Notes::CONTINUE){
+                if(c.getInstructionState()->instrument_index != current_instruction->instrument_index){
+                    c.selectInstrument(this->instruments_bank[current_instruction->instrument_index]);
+                }
+                c.setInstructionState(current_instruction);
+            }else{
+                if(!c.portamento){
+                    if(c.getInstructionState()->instrument_index != current_instruction->instrument_index){
+                        c.selectInstrument(this->instruments_bank[current_instruction->instrument_index]);
                     }
-                    res[0] += s * (1 - chan[i].panning);
-                    res[1] += s * chan[i].panning;
+                    c.setInstructionState(current_instruction);
+                }else{
+                    c.portamento_time_step = t;
+                    if(c.instruct_state.key.octave == Notes::CONTINUE){
+                        c.porta_pitch_dif = 0;
+                    }else{
+                        c.porta_pitch_dif += Notes::key2pitch(current_instruction->key) - (Notes::key2pitch(c.instruct_state.key) /*- c.porta_pitch_dif*/);
+                    }
+
+                    if(c.getInstructionState()->instrument_index != current_instruction->instrument_index){
+                        c.selectInstrument(this->instruments_bank[current_instruction->instrument_index]);
+                    }
+                    c.setInstructionState(current_instruction);
+                }
+            }
+            c.voice.release = false;
+            c.pitch_slide_val = 0;
+            c.pitch_slide_time = t;
+            c.transpose_time_step = t;
+            c.transpose_semitone_counter = 0;
+            c.retrieg_time_step = t;
+            c.retrieg_counter = 0;
+            c.delrel_time_step = t;
+            c.release_counter = 0;
+            c.delay_counter = 0;
+            if(c.n_time_to_transpose > 0){
+                --c.n_time_to_transpose;
+            }
+            if(c.n_time_to_retrieg > 0){
+                --c.n_time_to_retrieg;
+            }
+            if(c.n_time_to_delrel){
+                --c.n_time_to_delrel;
+            }
+        } else {
+            if (c.getLastInstructionAddress() != nullptr) {
+                if ((event->kinds & RowEvent::NOTE_RELEASE) &&
+                    c.getInstructionState()->instrument_index < this->instruments) {
+                    if (!c.isReleased()) {
+                        c.setRelease(true);
+                        c.setTimeRelease(t);
+                        c.setTrack(this);
+                        c.voice.release = true;
+                    }
+                    if (current_instruction->volume != Notes::CONTINUE &&
+                        ((0.f <= current_instruction->volume) &&
+                         (current_instruction->volume <= MASTER_VOLUME))) {
+                        c.setVolumeInstructionState(current_instruction->volume);
+                    }
+                }
+                if ((event->kinds & RowEvent::VOLUME_CHANGE) &&
+                    c.getInstructionState()->instrument_index < this->instruments) {
+                    c.setVolumeInstructionState(current_instruction->volume);
                 }
             }
         }
 
+        for (uint_fast8_t k = 0; k < event->effects; ++k) {
+            const EffectCommand &fx = this->commands[event->first_effect + k];
+            if (fx.type < EffectCommand::CHANNEL_EFFECTS) {
+                this->applyEffect(fx, t);
+            } else {
+                c.applyEffect(fx, t);
+            }
+        }
+    }
 
-        res[0] *= this->volume * this->tremolo_val;
-        res[1] *=  this->volume * this->tremolo_val;
+    float Track::playChannel(Channel &c, double t, float track_pitch) {
+        //check if channel is released because of release effect
+        if(c.isReleased()){
+            c.voice.release = true;
+        }
 
-        res[0] *= 4*(1 - this->panning);//left
-        res[1] *= 4*this->panning;//right
+        float a = this->voiceAmplitude(c);
+        float p = this->voiceBasePitch(c) + track_pitch + this->voiceModulation(c);
 
-        this->readFx = false;
-        this->time = t;
-        return res;
+        if (c.getLastInstructionAddress() != nullptr && c.getTrack() != nullptr) {
+            double note_time = t - c.getTime();
+            if (c.voice.staysIdle(&note_time, 1)) {//faded out, silent until its next note
+                return 0.f;
+            }
+            if (!c.isReleased()) {
+                return c.instrument->play_freq(c.voice, a, this->voiceFrequency(c, p), t - c.getTime());
+            } else {
+                return c.instrument->play_freq(c.voice, a, this->voiceFrequency(c, p), t - c.getTime(),
+                                               t - c.getTimeRelease());
+            }
+        }
+        return 0.f;
+    }
+
+    float Track::voiceAmplitude(const Channel &c) {
+        return c.getVolume() * c.tremolo_val * c.getInstructionState()->volume;
+    }
+
+    float Track::voiceBasePitch(const Channel &c) {
+        uint_fast8_t arpeggio = 0;
+        if(c.arpeggio){
+            arpeggio = c.arpeggio_val[c.arpeggio_index];
+        }
+        return Notes::key2pitch(c.getInstructionState()->key) + c.pitch + arpeggio - c.porta_pitch_dif;
+    }
+
+    float Track::voiceModulation(const Channel &c) {
+        return float(c.pitch_slide_val + c.vibrato_val);
+    }
+
+    void Track::renderChannelJob(void *segment, size_t i) {
+        Segment *s = static_cast<Segment *>(segment);
+        s->track->renderChannel(s->chan[i], uint_fast8_t(i), s->at, s->len, s->t, s->sample_rate, s->period);
+    }
+
+    void Track::renderChannel(Channel &c, uint_fast8_t i, size_t at, size_t len, double t, double sample_rate,
+                              size_t period) {
+        Voice &v = this->voices[i];
+        v.audible = false;
+        if (!c.isEnable()) {
+            return;
+        }
+        this->controlChannel(c, v, at, len, t, sample_rate, period);
+        v.audible = this->active[i];
+        if (this->active[i] && len > 1) {
+            //a voice whose envelope ended is not synthesized until its next note, its first sample was silent too
+            if (c.voice.staysIdle(&v.time[1], len - 1)) {
+                v.audible = false;
+                return;
+            }
+            float *left = &this->chan_buffer[(2 * i) * RENDER_BLOCK_SIZE];
+            float *right = &this->chan_buffer[(2 * i + 1) * RENDER_BLOCK_SIZE];
+            this->voiceFrequencies(c, v, 1, len - 1);
+            if (this->dry) {
+                c.instrument->skip(c.voice, len - 1, &v.freq[1], &v.time[1], &v.release_time[1]);
+                return;
+            }
+            c.instrument->play_freq(c.voice, &v.out[1], len - 1, &v.amp[1], &v.freq[1], &v.time[1], &v.release_time[1]);
+            for (size_t k = 1; k < len; ++k) {
+                left[k] = v.out[k] * (1 - v.panning[k]);
+                right[k] = v.out[k] * v.panning[k];
+            }
+        }
+    }
+
+    float Track::voiceFrequency(Channel &c, float p) {
+        if (p != c.cached_pitch) {
+            c.cached_pitch = p;
+            c.cached_freq = Notes::pitch2freq(p);
+        }
+        return c.cached_freq;
+    }
+
+    void Track::voiceFrequencies(Channel &c, Voice &v, size_t from, size_t n) {
+        const float *p = &v.pitch[from];
+        float *f = &v.freq[from];
+        size_t k = 0;
+        while (k < n && p[k] == p[0]) {
+            ++k;
+        }
+        if (k == n) {//held note : a single conversion, usually none at all
+            float freq = this->voiceFrequency(c, p[0]);
+            for (k = 0; k < n; ++k) {
+                f[k] = freq;
+            }
+        } else {//slide or vibrato : the whole block is converted
+            Notes::pitch2freq(f, p, n);
+            c.cached_pitch = p[n - 1];
+            c.cached_freq = f[n - 1];
+        }
+    }
+
+    void Track::controlChannel(Channel &c, Voice &v, size_t at, size_t len, double t, double sample_rate, size_t period) {
+        float amp = this->voiceAmplitude(c), mod = this->voiceModulation(c), pan = c.panning;
+        double dt = 1. / sample_rate;
+        for (size_t prev = 0; prev + 1 < len;) {
+            size_t end = (prev + period < len - 1) ? prev + period : len - 1;
+            bool control = c.getTrack() != nullptr;
+            if (control && c.hasTickEffects()) {//tick effects must happen on the very sample they are due
+                for (size_t k = prev + 1; k < end; ++k) {
+                    if (c.tickDue(t + double(at + k) / sample_rate)) {
+                        end = k;
+                        break;
+                    }
+                }
+            }
+
+            //until the control point, note, time and release state do not change
+            float base = this->voiceBasePitch(c);
+            bool delaying = control && c.isDelaying();//the note is held at its beginning while delayed
+            double note_time = c.getTime(), release_time = c.getTimeRelease();
+            bool released = c.isReleased();
+            for (size_t k = prev + 1; k < end; ++k) {
+                double tk = t + double(at + k) / sample_rate;
+                v.pitch[k] = base;
+                v.time[k] = delaying ? 0. : tk - note_time;
+                v.release_time[k] = released ? tk - release_time : -1.;
+            }
+
+            double tend = t + double(at + end) / sample_rate;
+            if (control) {
+                c.modulate(tend, end - prev, dt);
+                c.tick(tend);
+            }
+            if (c.isReleased()) {
+                c.voice.release = true;
+            }
+            v.pitch[end] = this->voiceBasePitch(c);
+            v.time[end] = tend - c.getTime();
+            v.release_time[end] = c.isReleased() ? tend - c.getTimeRelease() : -1.;
+
+            float next_amp = this->voiceAmplitude(c), next_mod = this->voiceModulation(c), next_pan = c.panning;
+            for (size_t k = prev + 1; k <= end; ++k) {
+                float w = float(k - prev) / float(end - prev);
+                v.amp[k] = amp + (next_amp - amp) * w;
+                v.pitch[k] += this->frame_pitch[k] + (mod + (next_mod - mod) * w);
+                v.panning[k] = pan + (next_pan - pan) * w;
+            }
+            amp = next_amp; mod = next_mod; pan = next_pan;
+            prev = end;
+        }
     }
 
     float Track::getPanning() {
-        return this->panning;
+        return this->state.panning;
     }
 
     float Track::getClock() {
@@ -360,7 +1020,7 @@ namespace C0deTracker {
     }
 
     float Track::getSpeed() {
-        return this->speed;
+        return this->state.speed;
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file wavetable.cpp
+ * @brief Wavetable class code, user-defined single-cycle tables
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    Wavetable::Wavetable(const float *samples, size_t length, ADSR amp_enveloppe, uint_fast8_t interpolation)
+            : Oscillator(SINUS) {
+        this->amp_envelope = amp_enveloppe;
+        this->interpolation = interpolation;
+        this->setTable(samples, length);
+    }
+
+    Wavetable::Wavetable(const uint8_t *steps, size_t length, uint_fast8_t bits, ADSR amp_enveloppe,
+                         uint_fast8_t interpolation) : Oscillator(SINUS) {
+        this->amp_envelope = amp_enveloppe;
+        this->interpolation = interpolation;
+        this->setTable(steps, length, bits);
+    }
+
+    Wavetable::~Wavetable() = default;
+
+    void Wavetable::setTable(const float *samples, size_t length) {
+        if (length == 0) {//a silent cycle of one sample
+            this->table.assign(3, 0.f);
+            return;
+        }
+        this->table.assign(samples, samples + length);
+        this->table.push_back(samples[0]);
+        this->table.push_back(samples[length > 1 ? 1 : 0]);
+    }
+
+    void Wavetable::setTable(const uint8_t *steps, size_t length, uint_fast8_t bits) {
+        bits = bits < 1 ? 1 : (bits > 16 ? 16 : bits);//2^bits - 1 must be a positive 32 bits shift
+        std::vector<float> samples(length);
+        auto top = float((1u << bits) - 1u);
+        for (size_t i = 0; i < length; ++i) {
+            samples[i] = float(steps[i]) / top - 0.5f;
+        }
+        this->setTable(samples.data(), length);
+    }
+
+    const float *Wavetable::getTable() const {
+        return this->table.data();
+    }
+
+    size_t Wavetable::getLength() const {
+        return this->table.size() - 2;
+    }
+
+    void Wavetable::setInterpolation(uint_fast8_t interpolation) { this->interpolation = interpolation;}
+    uint_fast8_t Wavetable::getInterpolation() const {return this->interpolation;}
+
+    float Wavetable::handleAmpEnvelope(VoiceState &v, double t, double rt) const {
+        float output;
+        this->amp_envelope.render(v, &output, 1, &t, &rt);
+        return MASTER_VOLUME * output;
+    }
+
+    float Wavetable::oscillate(VoiceState &v, float a, float f, double t, double rt, float dc, float p) const {
+        float envelope = this->handleAmpEnvelope(v, t, rt);
+        float ph = this->advancePhase(v, f, t, dc, p);
+        float out;
+        Oscillator::readTable(&out, 1, &a, &ph, this->table.data(), this->getLength(),
+                              this->interpolation == LINEAR);
+        return envelope * out;
+    }
+
+    float Wavetable::oscillate(VoiceState &v, float a, float f, double t, float dc, float p) const {
+        return this->oscillate(v, a, f, t, -1.f, dc, p);
+    }
+
+    void Wavetable::oscillate(VoiceState &v, float *out, size_t n, const float *a, const float *f, const double *t,
+                              const double *rt, float dc, float p) const {
+        float ph[RENDER_BLOCK_SIZE];
+        for (size_t done = 0; done < n; done += RENDER_BLOCK_SIZE) {
+            size_t m = (n - done < RENDER_BLOCK_SIZE) ? n - done : RENDER_BLOCK_SIZE;
+            for (size_t k = 0; k < m; ++k) {
+                ph[k] = this->advancePhase(v, f[done + k], t[done + k], dc, p);
+            }
+            Oscillator::readTable(out + done, m, a + done, ph, this->table.data(), this->getLength(),
+                                  this->interpolation == LINEAR);
+        }
+        this->applyAmpEnvelope(v, out, n, t, rt);
+    }
+
+    void Wavetable::skip(VoiceState &v, size_t n, const float *f, const double *t, const double *rt, float dc,
+                         float p) const {
+        Oscillator::skip(v, n, f, t, rt, dc, p);
+        this->skipAmpEnvelope(v, n, t, rt);
+    }
+
+    const ADSR* Wavetable::getAmpEnvelope() const {
+        return (&this->amp_envelope);
+    }
+
+    Wavetable * Wavetable::clone() const {
+        return new Wavetable(*this);
+    }
+}
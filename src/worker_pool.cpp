@@ -0,0 +1,101 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file worker_pool.cpp
+ * @brief WorkerPool class code
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+namespace C0deTracker {
+
+    WorkerPool::WorkerPool(unsigned threads) {
+        for (unsigned i = 1; i < threads; ++i) {
+            this->workers.emplace_back(&WorkerPool::work, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->quit = true;
+        }
+        this->wake.notify_all();
+        for (std::thread &worker : this->workers) {
+            worker.join();
+        }
+    }
+
+    unsigned WorkerPool::getThreads() const {
+        return unsigned(this->workers.size()) + 1;
+    }
+
+    void WorkerPool::run(size_t jobs, Job job, void *context) {
+        if (this->workers.empty() || jobs < 2) {
+            for (size_t i = 0; i < jobs; ++i) {
+                job(context, i);
+            }
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            //a late worker may still be leaving the previous run
+            this->finished.wait(lock, [this] { return this->busy == 0; });
+            this->job = job;
+            this->context = context;
+            this->jobs = jobs;
+            this->pending = jobs;
+            this->next.store(0);
+            ++this->generation;
+        }
+        this->wake.notify_all();
+        this->take(job, context, jobs);
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->finished.wait(lock, [this] { return this->pending == 0 && this->busy == 0; });
+    }
+
+    void WorkerPool::work() {
+        uint_fast64_t seen = 0;
+        for (;;) {
+            Job job;
+            void *context;
+            size_t jobs;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->wake.wait(lock, [this, seen] { return this->quit || this->generation != seen; });
+                if (this->quit) {
+                    return;
+                }
+                seen = this->generation;
+                job = this->job;
+                context = this->context;
+                jobs = this->jobs;
+                ++this->busy;
+            }
+            this->take(job, context, jobs);
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                --this->busy;
+            }
+            this->finished.notify_all();
+        }
+    }
+
+    void WorkerPool::take(Job job, void *context, size_t jobs) {
+        size_t done = 0;
+        for (size_t i = this->next.fetch_add(1); i < jobs; i = this->next.fetch_add(1)) {
+            job(context, i);
+            ++done;
+        }
+        if (done > 0) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending -= done;
+        }
+    }
+}
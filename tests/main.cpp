@@ -0,0 +1,318 @@
+//
+// Created by Abdulmajid, Olivier NASSER on 16/10/2026.
+//
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../include/c0de_tracker.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Headless checks of the engine, each one renders small songs written with SongData (or single oscillators)
+ * and compares the samples.
+ * Build it with every .cpp file of src/, SFML is not needed.
+ * Usage : tests
+ * @see code_tracker.hpp
+ * @author Abdulmajid, Olivier NASSER
+ * @version 0.1
+ * @date 16/10/2026
+ */
+
+#define TEST_SAMPLE_RATE 48000.
+#define TEST_ROWS 4
+#define TEST_FRAMES 8
+#define TEST_CHANNELS 1
+#define TEST_SECONDS 4. //rendered length of a song, longer than its 8 frames so that the loop is played too
+#define TEST_EXPORT_THREADS 4
+//a render starting at t reads its samples at t + k / rate, which rounds differently from the k / rate of a render
+//starting at 0, so the envelopes of both can differ in their last bits
+#define TEST_TIME_TOLERANCE 1e-6f
+#define TEST_BLOCK 1001 //samples of an oscillator block, not a multiple of the SIMD width so the tails are checked
+
+using C0deTracker::Key;
+using C0deTracker::SongData;
+using TestSong = SongData<TEST_ROWS, TEST_FRAMES, TEST_CHANNELS>;
+
+static constexpr uint_fast8_t fx_per_chan[TEST_CHANNELS] = {1};
+
+/**
+ * @brief a different note at the start of every frame and released on the third row, an effect can be added on the
+ * second row of a frame
+ */
+static constexpr TestSong scale(uint_fast32_t effect, uint_fast8_t frame = 0) {
+    TestSong song(fx_per_chan);
+    song.storeChannelIndex(0);
+    song.storeInstrumentIndex(0);
+    song.storeVolume(1.f);
+    for (uint_fast8_t f = 0; f < TEST_FRAMES; ++f) {
+        song.storePatternIndex(f);
+        song.enterInstruction(0, Key(float(f), 4));
+        song.release(2);
+    }
+    if (effect != 0) {
+        song.storePatternIndex(frame);
+        song.enterInstruction(1, effect);
+    }
+    return song;
+}
+
+/**
+ * @brief creates a track of the song with a single square instrument
+ */
+static C0deTracker::Track *createTrack(const TestSong &song) {
+    auto **instruments_bank = new C0deTracker::Instrument*[1];
+    instruments_bank[0] = new C0deTracker::Instrument(new C0deTracker::PSG(C0deTracker::SQUARE, 0.5f,
+                                                      C0deTracker::ADSR(100.f, 10.f, 0.5f, 10.f)), 1.f);
+    return song.createTrack(60.f, 3.f, 2.f, instruments_bank, 1);
+}
+
+static constexpr TestSong plain_song = scale(0);
+static constexpr TestSong jump_song = scale(0x0A005002, 2);//frame 2 jumps to the third row of frame 5
+static constexpr TestSong stop_song = scale(0x0B000000, 4);
+static const TestSong *const songs[] = {&plain_song, &jump_song, &stop_song};
+
+/**
+ * @brief renders TEST_SECONDS of the song in one call with new channels
+ */
+static std::vector<float> render(C0deTracker::Track *track) {
+    auto frames = size_t(TEST_SECONDS * TEST_SAMPLE_RATE);
+    std::vector<float> out(2 * frames);
+    std::vector<C0deTracker::Channel> chans;
+    for (uint_fast8_t i = 0; i < TEST_CHANNELS; ++i) {
+        chans.emplace_back(i);
+    }
+    track->render(out.data(), frames, 0., TEST_SAMPLE_RATE, chans.data(), TEST_CHANNELS);
+    return out;
+}
+
+/**
+ * @brief a jump to frame 0x105 does not fit the song, it must be left out instead of wrapping to frame 5
+ */
+static bool jumpOutOfRange() {
+    static constexpr TestSong plain = scale(0);
+    static constexpr TestSong jump = scale(0x0A105000);
+    C0deTracker::Track *a = createTrack(plain);
+    C0deTracker::Track *b = createTrack(jump);
+    bool same = render(a) == render(b);
+    delete a;
+    delete b;
+    return same;
+}
+
+/**
+ * @brief exportSong gives the samples of a single render call, on one thread and on several
+ */
+static bool exportMatchesRender() {
+    auto frames = size_t(TEST_SECONDS * TEST_SAMPLE_RATE);
+    std::vector<float> out(2 * frames);
+    bool same = true;
+    for (const TestSong *song : songs) {
+        C0deTracker::Track *track = createTrack(*song);
+        std::vector<float> played = render(track);
+        delete track;
+        for (unsigned threads : {1u, unsigned(TEST_EXPORT_THREADS)}) {
+            track = createTrack(*song);
+            track->exportSong(out.data(), frames, TEST_SAMPLE_RATE, threads);
+            same = same && out == played;
+            delete track;
+        }
+    }
+    return same;
+}
+
+/**
+ * @return true if the samples differ by at most TEST_TIME_TOLERANCE
+ */
+static bool near(const float *a, const float *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (std::fabs(a[i] - b[i]) > TEST_TIME_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief after a seek, render goes on with the samples the song plays from its beginning, before and after the loop
+ * and backwards. The seeks from checkpoints give exactly the samples of the seeks replaying the song from its start.
+ */
+static bool seekMatchesPlayback() {
+    const double times[] = {0.35, 1.25, 2.9, 3.5, 0.8};
+    auto frames = size_t(TEST_SECONDS * TEST_SAMPLE_RATE);
+    std::vector<float> replayed(2 * frames), restored(2 * frames);
+    bool same = true;
+    for (const TestSong *song : songs) {
+        C0deTracker::Track *track = createTrack(*song);
+        C0deTracker::Track *indexed = createTrack(*song);
+        std::vector<float> played = render(track);
+        indexed->buildCheckpoints(TEST_SECONDS, TEST_SAMPLE_RATE);
+        C0deTracker::Channel a(0), b(0);
+        for (double time : times) {
+            auto at = size_t(time * TEST_SAMPLE_RATE);
+            double t = double(at) / TEST_SAMPLE_RATE;
+            track->seek(t, TEST_SAMPLE_RATE, &a, TEST_CHANNELS);
+            track->render(replayed.data(), frames - at, t, TEST_SAMPLE_RATE, &a, TEST_CHANNELS);
+            indexed->seek(t, TEST_SAMPLE_RATE, &b, TEST_CHANNELS);
+            indexed->render(restored.data(), frames - at, t, TEST_SAMPLE_RATE, &b, TEST_CHANNELS);
+            same = same && replayed == restored && near(replayed.data(), &played[2 * at], 2 * (frames - at));
+        }
+        delete track;
+        delete indexed;
+    }
+    return same;
+}
+
+/**
+ * @brief a channel muted by the user stays muted when the track seeks, from the beginning or from a checkpoint
+ */
+static bool seekDisabledChannel() {
+    static constexpr TestSong song = scale(0);
+    C0deTracker::Track *track = createTrack(song);
+    auto frames = size_t(double(track->getDuration()) * TEST_SAMPLE_RATE) / 2;
+    std::vector<float> out(2 * frames), silence(2 * frames, 0.f);
+    C0deTracker::Channel chan(0);
+    chan.disable();
+    bool muted = true;
+    for (int checkpoints = 0; checkpoints < 2; ++checkpoints) {
+        if (checkpoints) {
+            track->buildCheckpoints(double(track->getDuration()), TEST_SAMPLE_RATE);
+        }
+        track->seek(double(frames) / TEST_SAMPLE_RATE, TEST_SAMPLE_RATE, &chan, TEST_CHANNELS);
+        track->render(out.data(), frames, double(frames) / TEST_SAMPLE_RATE, TEST_SAMPLE_RATE, &chan, TEST_CHANNELS);
+        muted = muted && !chan.isEnable() && out == silence;
+    }
+    delete track;
+    return muted;
+}
+
+/**
+ * @brief the ring buffer rounds its capacity up to a power of two, refuses what does not fit, gives back nothing when
+ * empty and keeps the order of the samples across many wraparounds
+ */
+static bool ringBuffer() {
+    C0deTracker::RingBuffer ring(5);//8 floats
+    float data[16], back[16];
+    for (size_t k = 0; k < 16; ++k) {
+        data[k] = float(k);
+    }
+    bool ok = ring.space() == 8 && ring.available() == 0 && ring.read(back, 4) == 0;
+    ok = ok && ring.write(data, 16) == 8 && ring.space() == 0 && ring.write(data, 1) == 0;
+    ok = ok && ring.read(back, 3) == 3 && back[0] == 0.f && back[2] == 2.f && ring.available() == 5;
+    ok = ok && ring.write(data + 8, 3) == 3 && ring.read(back, 16) == 8 && ring.available() == 0;
+    const float order[8] = {3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f, 10.f};
+    ok = ok && std::memcmp(back, order, sizeof(order)) == 0;
+
+    //chunks of 1 to 7 floats written and read in turn, the read sequence is the written one
+    float next_write = 0.f, next_read = 0.f;
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t n = 1 + i % 7, m = 1 + (i * 3) % 7;
+        for (size_t k = 0; k < n; ++k) {
+            data[k] = next_write + float(k);
+        }
+        next_write += float(ring.write(data, n));
+        size_t got = ring.read(back, m);
+        for (size_t k = 0; k < got; ++k) {
+            ok = ok && back[k] == next_read++;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief pull fills with silence what the render thread has not rendered yet and counts the missing samples, the
+ * thread renders once started and its samples are dropped when it stops
+ */
+static bool renderThreadUnderruns() {
+    static constexpr TestSong song = scale(0);
+    C0deTracker::Track *track = createTrack(song);
+    C0deTracker::Channel chan(0);
+    C0deTracker::RenderThread renderer(track, &chan, TEST_CHANNELS, TEST_SAMPLE_RATE, 1024);
+    std::vector<float> out(200, 1.f), silence(200, 0.f);
+    //not started : nothing is rendered
+    bool ok = renderer.getUnderruns() == 0 && renderer.pull(out.data(), 100) == 0 && out == silence;
+    ok = ok && renderer.getUnderruns() == 100 && renderer.pull(out.data(), 50) == 0 && renderer.getUnderruns() == 150;
+    //started : the look-ahead fills up in a few blocks, stopped : the samples left are dropped
+    renderer.start(0.);
+    size_t ready = 0;
+    for (int tries = 0; ready == 0 && tries < 1000; ++tries) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ready = renderer.pull(out.data(), 100);
+    }
+    renderer.stop();
+    ok = ok && ready > 0 && renderer.pull(out.data(), 100) == 0;
+    delete track;
+    return ok;
+}
+
+/**
+ * @brief renders a block of a sweep from 50 Hz to 8 kHz with an oscillator, from a new voice
+ */
+static std::vector<float> sweep(const C0deTracker::Oscillator &osc) {
+    std::vector<float> out(TEST_BLOCK), a(TEST_BLOCK, 0.8f), f(TEST_BLOCK);
+    std::vector<double> t(TEST_BLOCK), rt(TEST_BLOCK, -1.);
+    for (size_t k = 0; k < TEST_BLOCK; ++k) {
+        f[k] = 50.f + 7950.f * float(k) / TEST_BLOCK;
+        t[k] = double(k) / TEST_SAMPLE_RATE;
+    }
+    C0deTracker::VoiceState v;
+    osc.oscillate(v, out.data(), TEST_BLOCK, a.data(), f.data(), t.data(), rt.data(), osc.getDutycycle(),
+                  osc.getPhase());
+    return out;
+}
+
+/**
+ * @brief the SIMD kernels give the same samples as the scalar ones, for every waveform and table reader
+ */
+static bool simdMatchesScalar() {
+    using namespace C0deTracker;
+    ADSR envelope(100.f, 10.f, 0.5f, 10.f);
+    const float samples[5] = {0.f, 0.5f, -0.25f, 0.125f, -0.5f};
+    std::vector<Oscillator*> oscillators;
+    for (uint_fast8_t w = 0; w < WAVETYPES; ++w) {
+        oscillators.push_back(new PSG(w, 0.3f, envelope));
+    }
+    oscillators.push_back(new BandLimitedPSG(SQUARE, 0.3f, envelope));
+    oscillators.push_back(new BandLimitedPSG(TRIANGLE, 0.3f, envelope));
+    oscillators.push_back(new BandLimitedPSG(SAW, 0.3f, envelope));
+    oscillators.push_back(new Wavetable(samples, 5, envelope, Wavetable::NEAREST));
+    oscillators.push_back(new Wavetable(samples, 5, envelope, Wavetable::LINEAR));
+
+    bool same = true;
+    for (const Oscillator *osc : oscillators) {
+        Oscillator::enableSimd(false);
+        std::vector<float> scalar = sweep(*osc);
+        Oscillator::enableSimd(true);
+        same = same && std::memcmp(scalar.data(), sweep(*osc).data(), TEST_BLOCK * sizeof(float)) == 0;
+        delete osc;
+    }
+    std::fprintf(stderr, "kernels compared with the %s ones\n", Oscillator::getInstructionSet());
+    return same;
+}
+
+int main() {
+    struct Test{
+        const char *name;
+        bool (*run)();
+    };
+    const Test tests[] = {
+            {"jump out of range", jumpOutOfRange},
+            {"seek with a disabled channel", seekDisabledChannel},
+            {"export matches render", exportMatchesRender},
+            {"seek matches playback", seekMatchesPlayback},
+            {"ring buffer", ringBuffer},
+            {"render thread underruns", renderThreadUnderruns},
+            {"SIMD kernels match the scalar ones", simdMatchesScalar},
+    };
+
+    int failures = 0;
+    for (const Test &test : tests) {
+        bool passed = test.run();
+        std::fprintf(stderr, "%s : %s\n", test.name, passed ? "ok" : "FAILED");
+        failures += !passed;
+    }
+    return failures == 0 ? 0 : 1;
+}